@@ -23,13 +23,22 @@ limitations under the License.
 #include "clang/Driver/Driver.h"
 #include "clang/Driver/Tool.h"
 #include "lld/Common/Driver.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/Analysis/TargetLibraryInfo.h"
 #include "llvm/CodeGen/CommandFlags.h"
 #include "llvm/CodeGen/MachineModuleInfo.h"
+#include "llvm/CodeGen/ParallelCG.h"
+#include "llvm/ExecutionEngine/Orc/ExecutionUtils.h"
+#include "llvm/ExecutionEngine/Orc/LLJIT.h"
+#include "llvm/ExecutionEngine/Orc/ThreadSafeModule.h"
 #include "llvm/IR/AutoUpgrade.h"
+#include "llvm/IR/DiagnosticInfo.h"
+#include "llvm/IR/DiagnosticPrinter.h"
 #include "llvm/IR/LegacyPassManager.h"
 #include "llvm/IR/PassManager.h"
+#include "llvm/IRReader/IRReader.h"
 #include "llvm/InitializePasses.h"
+#include "llvm/Linker/Linker.h"
 #include "llvm/MC/TargetRegistry.h"
 #include "llvm/Pass.h"
 #include "llvm/PassRegistry.h"
@@ -41,14 +50,19 @@ limitations under the License.
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/PGOOptions.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/Program.h"
+#include "llvm/Support/SourceMgr.h"
 #include "llvm/Support/TargetSelect.h"
+#include "llvm/Support/VirtualFileSystem.h"
+#include "llvm/Support/Threading.h"
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/raw_ostream.h"
 #include "llvm/Target/TargetMachine.h"
 #include "llvm/TargetParser/Host.h"
 #include "llvm/Transforms/Instrumentation/SanitizerCoverage.h"
+#include "llvm/Transforms/Utils/Cloning.h"
 #include "llvm/Transforms/Utils/Mem2Reg.h"
 #include "mlir/Conversion/FuncToLLVM/ConvertFuncToLLVMPass.h"
 #include "mlir/Target/LLVMIR/Dialect/Builtin/BuiltinToLLVMIRTranslation.h"
@@ -126,12 +140,97 @@ class AddWindowsDLLExportPass: public PassInfoMixin<AddWindowsDLLExportPass>
 
 static const bool printTimings = false;
 
+// links the bitcode of the runtime into the module, so that the optimizer can
+// inline the runtime functions into the generated code, as LTO would. If the
+// bitcode can't be read or linked, for example because it was written by
+// another version of LLVM, the module is left untouched and the runtime
+// library, which is passed to the linker too, provides the runtime instead.
+static void linkRuntimeBitcode(
+		std::unique_ptr<llvm::Module> &M, llvm::StringRef path)
+{
+	auto warn = [&]() -> llvm::raw_ostream & {
+		return llvm::errs() << "rlc: warning: linking the runtime library instead "
+													 "of the runtime bitcode "
+												<< path << ": ";
+	};
+
+	// the default handler exits on the first error, so while the bitcode is
+	// read and linked its errors are printed as warnings instead
+	auto &context = M->getContext();
+	auto previousHandler = context.getDiagnosticHandler();
+	context.setDiagnosticHandlerCallBack(
+			[](const llvm::DiagnosticInfo &info, void *) {
+				llvm::DiagnosticPrinterRawOStream printer(llvm::errs());
+				llvm::errs() << "rlc: warning: ";
+				info.print(printer);
+				llvm::errs() << "\n";
+			});
+	auto restoreHandler = llvm::make_scope_exit(
+			[&]() { context.setDiagnosticHandler(std::move(previousHandler)); });
+
+	llvm::SMDiagnostic error;
+	auto runtime = llvm::parseIRFile(path, error, context);
+	if (not runtime)
+	{
+		warn() << error.getMessage() << "\n";
+		return;
+	}
+
+	// the runtime is compiled for the host by clang, which tags every function
+	// with the cpu it was built for. Without a target machine the inliner
+	// refuses to inline across functions whose tags differ, and the generated
+	// functions have none.
+	for (auto &function : *runtime)
+	{
+		function.removeFnAttr("target-cpu");
+		function.removeFnAttr("target-features");
+		function.removeFnAttr("tune-cpu");
+	}
+	runtime->setDataLayout(M->getDataLayout());
+	runtime->setTargetTriple(M->getTargetTriple());
+
+	// the linker can leave its destination half linked when it fails, so the
+	// runtime is linked into a copy that replaces the module on success
+	auto linked = llvm::CloneModule(*M);
+	if (llvm::Linker::linkModules(*linked, std::move(runtime)))
+	{
+		warn() << "could not link it\n";
+		return;
+	}
+	M = std::move(linked);
+}
+
+// instrumentation to write a profile, or a profile to read, that the pass
+// builder adds to the pipelines it builds.
+static std::optional<llvm::PGOOptions> getPGOOptions(
+		bool generate, llvm::StringRef outputFile, llvm::StringRef profile)
+{
+	if (generate)
+		return llvm::PGOOptions(
+				outputFile.str(),
+				"",
+				"",
+				"",
+				llvm::vfs::getRealFileSystem(),
+				llvm::PGOOptions::IRInstr);
+	if (not profile.empty())
+		return llvm::PGOOptions(
+				profile.str(),
+				"",
+				"",
+				"",
+				llvm::vfs::getRealFileSystem(),
+				llvm::PGOOptions::IRUse);
+	return std::nullopt;
+}
+
 static void runOptimizer(
 		llvm::Module &M,
 		bool optimize,
 		bool emitSanitizerInstrumentation,
 		bool linkAgainsFuzzer,
-		bool targetIsWindows)
+		bool targetIsWindows,
+		std::optional<llvm::PGOOptions> pgoOptions)
 {
 	llvm::PassInstrumentationCallbacks PIC;
 	llvm::StandardInstrumentations SI(M.getContext(), /*DebugLogging=*/false);
@@ -154,7 +253,7 @@ static void runOptimizer(
 	// Take a look at the PassBuilder constructor parameters for more
 	// customization, e.g. specifying a TargetMachine or various debugging
 	// options.
-	PassBuilder PB(nullptr, llvm::PipelineTuningOptions(), std::nullopt, &PIC);
+	PassBuilder PB(nullptr, llvm::PipelineTuningOptions(), pgoOptions, &PIC);
 
 	// Register all the basic analyses with the managers.
 	PB.registerModuleAnalyses(MAM);
@@ -208,19 +307,24 @@ struct mlir::rlc::TargetInfoImpl
 		target = llvm::TargetRegistry::lookupTarget("", this->triple, Error);
 		assert(target);
 		options = llvm::codegen::InitTargetOptionsFromCodeGenFlags(this->triple);
+		targetMachine = createTargetMachine();
 
-		auto *Ptr = target->createTargetMachine(
-				this->triple.getTriple(),
+		datalayout =
+				std::make_unique<llvm::DataLayout>(targetMachine->createDataLayout());
+	}
+
+	// target machines can't be shared across threads, each code generation
+	// job creates its own.
+	std::unique_ptr<llvm::TargetMachine> createTargetMachine() const
+	{
+		return unique_ptr<TargetMachine>(target->createTargetMachine(
+				triple.getTriple(),
 				"",
 				"",
 				options,
 				reloc,
 				llvm::CodeModel::Large,
-				this->optimize);
-		targetMachine = unique_ptr<TargetMachine>(Ptr);
-
-		datalayout =
-				std::make_unique<llvm::DataLayout>(targetMachine->createDataLayout());
+				optimize));
 	}
 
 	llvm::Triple triple;
@@ -306,6 +410,86 @@ static void compile(
 	OS.flush();
 }
 
+// splits the module in as many partitions as there are streams and
+// generates their code in parallel, each in a LLVMContext of its own.
+static void compileInParallel(
+		const mlir::rlc::TargetInfo &info,
+		std::unique_ptr<llvm::Module> M,
+		llvm::ArrayRef<llvm::raw_pwrite_stream *> OSs)
+{
+	M->setDataLayout(*info.pimpl->datalayout);
+	llvm::UpgradeDebugInfo(*M);
+
+	llvm::splitCodeGen(
+			*M,
+			OSs,
+			{},
+			[&]() { return info.pimpl->createTargetMachine(); },
+			llvm::CodeGenFileType::ObjectFile);
+	for (auto *OS : OSs)
+		OS->flush();
+}
+
+// compiles the module in process with ORC and runs its main function. The
+// symbols of the runtime are resolved from the extra object files, which are
+// either objects or static libraries, and the ones of the C library from the
+// process itself.
+static llvm::Expected<int> runInJit(
+		std::unique_ptr<llvm::LLVMContext> context,
+		std::unique_ptr<llvm::Module> M,
+		llvm::ArrayRef<std::string> extraObjectFiles)
+{
+	using namespace llvm::orc;
+	auto jit = LLJITBuilder().create();
+	if (not jit)
+		return jit.takeError();
+
+	auto &mainLibrary = (*jit)->getMainJITDylib();
+	auto processSymbols = DynamicLibrarySearchGenerator::GetForCurrentProcess(
+			(*jit)->getDataLayout().getGlobalPrefix());
+	if (not processSymbols)
+		return processSymbols.takeError();
+	mainLibrary.addGenerator(std::move(*processSymbols));
+
+	for (const auto &file : extraObjectFiles)
+	{
+		auto extension = llvm::sys::path::extension(file);
+		if (extension == ".o" or extension == ".obj")
+		{
+			auto buffer =
+					llvm::errorOrToExpected(llvm::MemoryBuffer::getFile(file));
+			if (not buffer)
+				return buffer.takeError();
+			if (auto error = (*jit)->addObjectFile(std::move(*buffer)))
+				return std::move(error);
+			continue;
+		}
+
+		auto library = StaticLibraryDefinitionGenerator::Load(
+				(*jit)->getObjLinkingLayer(), file.c_str());
+		if (not library)
+			return library.takeError();
+		mainLibrary.addGenerator(std::move(*library));
+	}
+
+	M->setDataLayout((*jit)->getDataLayout());
+	M->setTargetTriple((*jit)->getTargetTriple().str());
+	if (auto error = (*jit)->addIRModule(
+					ThreadSafeModule(std::move(M), std::move(context))))
+		return std::move(error);
+	if (auto error = (*jit)->initialize(mainLibrary))
+		return std::move(error);
+
+	auto mainFunction = (*jit)->lookup("main");
+	if (not mainFunction)
+		return mainFunction.takeError();
+	int result = mainFunction->toPtr<int()>()();
+
+	if (auto error = (*jit)->deinitialize(mainLibrary))
+		return std::move(error);
+	return result;
+}
+
 static mlir::LogicalResult getLinkerInvocation(
 		llvm::StringRef clangPath,
 		llvm::ArrayRef<string> clangInvocation,
@@ -420,7 +604,7 @@ static mlir::LogicalResult getLinkerInvocation(
 }
 
 static int linkLibraries(
-		llvm::ToolOutputFile &library,
+		llvm::ArrayRef<std::string> objectFiles,
 		llvm::StringRef clangPath,
 		llvm::StringRef outputFile,
 		bool shared,
@@ -429,7 +613,8 @@ static int linkLibraries(
 		const std::vector<std::string> &extraObjectFiles,
 		const std::vector<std::string> &rpaths,
 		const mlir::rlc::TargetInfo &info,
-		bool verbose)
+		bool verbose,
+		bool profileGeneration)
 {
 	auto failedToFindClang = false;
 	auto maybeRealPath =
@@ -456,7 +641,8 @@ static int linkLibraries(
 	std::string Errors;
 	llvm::SmallVector<std::string, 4> argSource;
 	argSource.push_back("clang");
-	argSource.push_back(library.getFilename().str());
+	for (const auto &objectFile : objectFiles)
+		argSource.push_back(objectFile);
 	argSource.push_back("--target=" + info.tripleToString());
 	if (info.isWindows())
 	{
@@ -517,6 +703,10 @@ static int linkLibraries(
 		argSource.push_back(arg);
 	}
 
+	// makes clang link the runtime that writes the profile
+	if (profileGeneration)
+		argSource.push_back("-fprofile-generate");
+
 	for (auto extraObject : extraObjectFiles)
 		argSource.push_back(extraObject);
 
@@ -548,18 +738,22 @@ namespace mlir::rlc
 		using impl::RLCBackEndPassBase<RLCBackEndPass>::RLCBackEndPassBase;
 		void runOnOperation()
 		{
-			LLVMContext LLVMcontext;
+			auto LLVMcontext = std::make_unique<LLVMContext>();
 			auto Module = mlir::translateModuleToLLVMIR(
-					getOperation(), LLVMcontext, getOperation().getName().value());
+					getOperation(), *LLVMcontext, getOperation().getName().value());
 			assert(Module);
 			Module->setTargetTriple(targetInfo->tripleToString());
 
+			if (not runtimeBitcode.empty())
+				linkRuntimeBitcode(Module, runtimeBitcode);
+
 			runOptimizer(
 					*Module,
 					targetInfo->optimize(),
 					emitSanitizer,
 					emitFuzzer,
-					targetInfo->isWindows());
+					targetInfo->isWindows(),
+					getPGOOptions(pgoGen, pgoGenFile, pgoUse));
 
 			if (dumpIR)
 			{
@@ -567,32 +761,83 @@ namespace mlir::rlc
 				return;
 			}
 
-			error_code errorCompile;
-			std::string realOut = outputFile;
-			if (realOut != "-")
-				realOut = compileOnly ? outputFile : outputFile + ".o";
-			llvm::ToolOutputFile library(
-					realOut, errorCompile, llvm::sys::fs::OpenFlags::OF_None);
-
-			error_code error;
-			if (errorCompile)
+			if (jit)
 			{
-				errs() << error.message();
-				signalPassFailure();
+				if (emitSanitizer or emitFuzzer or pgoGen)
+				{
+					errs() << "the sanitizer, the fuzzer and the profile generation "
+										"can't be used when jitting\n";
+					signalPassFailure();
+					return;
+				}
+
+				auto exitCode = runInJit(
+						std::move(LLVMcontext), std::move(Module), *extraObjectFiles);
+				if (not exitCode)
+				{
+					errs() << llvm::toString(exitCode.takeError()) << "\n";
+					signalPassFailure();
+					return;
+				}
+				if (jitExitCode != nullptr)
+					*jitExitCode = *exitCode;
 				return;
 			}
 
-			compile(*targetInfo, std::move(Module), library.os());
-			library.os().close();
+			// partitions must be linked back together, so a single object file is
+			// emitted when the object file itself is the output
+			unsigned partitions = jobs;
+			if (partitions == 0)
+				partitions =
+						llvm::heavyweight_hardware_concurrency().compute_thread_count();
+			if (compileOnly or outputFile == "-")
+				partitions = 1;
+
+			std::vector<std::unique_ptr<llvm::ToolOutputFile>> objects;
+			for (unsigned i = 0; i != partitions; i++)
+			{
+				std::string realOut = outputFile;
+				if (realOut != "-" and not compileOnly)
+					realOut = partitions == 1
+												? outputFile + ".o"
+												: outputFile + "." + std::to_string(i) + ".o";
+
+				error_code errorCompile;
+				objects.push_back(std::make_unique<llvm::ToolOutputFile>(
+						realOut, errorCompile, llvm::sys::fs::OpenFlags::OF_None));
+				if (errorCompile)
+				{
+					errs() << errorCompile.message();
+					signalPassFailure();
+					return;
+				}
+			}
+
+			if (partitions == 1)
+			{
+				compile(*targetInfo, std::move(Module), objects.front()->os());
+			}
+			else
+			{
+				llvm::SmallVector<llvm::raw_pwrite_stream *, 4> streams;
+				for (auto &object : objects)
+					streams.push_back(&object->os());
+				compileInParallel(*targetInfo, std::move(Module), streams);
+			}
+			for (auto &object : objects)
+				object->os().close();
 
 			if (compileOnly)
 			{
-				library.keep();
+				objects.front()->keep();
 				return;
 			}
 
+			std::vector<std::string> objectFiles;
+			for (auto &object : objects)
+				objectFiles.push_back(object->getFilename().str());
 			if (linkLibraries(
-							library,
+							objectFiles,
 							clangPath,
 							outputFile,
 							targetInfo->isShared(),
@@ -601,7 +846,8 @@ namespace mlir::rlc
 							*extraObjectFiles,
 							*rpaths,
 							*targetInfo,
-							verbose) != 0)
+							verbose,
+							pgoGen) != 0)
 				signalPassFailure();
 		}
 	};
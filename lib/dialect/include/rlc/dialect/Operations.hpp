@@ -90,6 +90,19 @@ namespace mlir::rlc
 		return op->hasAttr("synthetic");
 	}
 
+	// mark a function as being the one emitted by LowerActionPass to invoke a
+	// action statement, that is, the function that apply ends up calling.
+	inline void markActionStatementWrapper(mlir::Operation* op)
+	{
+		op->setAttr(
+				"action_statement_wrapper", mlir::UnitAttr::get(op->getContext()));
+	}
+
+	inline bool isActionStatementWrapper(mlir::Operation* op)
+	{
+		return op->hasAttr("action_statement_wrapper");
+	}
+
 	struct ActionFrameContent
 	{
 		public:
@@ -135,6 +148,15 @@ namespace mlir::rlc
 
 	void lowerForFields(mlir::rlc::ModuleBuilder& builder, mlir::Operation* op);
 
+	// returns the function op a can operation refers to, if it is known
+	mlir::rlc::FunctionOp getCanCallee(mlir::rlc::CanOp op);
+
+	// finds the action statement wrapper invoked by the precondition of
+	// apply(GameX self, Game frame), which is just can(statement)(frame,
+	// self.members...)
+	mlir::rlc::FunctionOp findStatementWrapper(
+			mlir::rlc::FunctionOp applyFunction);
+
 	void lowerDestructors(
 			llvm::DenseMap<mlir::Type, bool>& requireDestructor,
 			mlir::rlc::ModuleBuilder& builder,
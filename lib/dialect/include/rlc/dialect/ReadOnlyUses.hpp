@@ -0,0 +1,43 @@
+/*
+Copyright 2024 Massimo Fioravanti
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#pragma once
+
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "mlir/IR/Operation.h"
+#include "rlc/dialect/Operations.hpp"
+
+namespace mlir::rlc
+{
+
+	// tells if a use of a reference can only read the referred object. Member
+	// and array accesses are read only if their results are, calls are followed
+	// into their callee, the other operations are considered writes.
+	// Must run after templates have been instantiated, so that every callee is
+	// known.
+	class ReadOnlyUses
+	{
+		public:
+		bool isReadOnly(mlir::OpOperand& use);
+		bool isReadOnly(mlir::Value value);
+
+		private:
+		bool isReadOnlyArgument(mlir::rlc::FunctionOp fun, unsigned index);
+
+		llvm::DenseMap<std::pair<mlir::Operation*, unsigned>, bool> cache;
+		llvm::DenseSet<std::pair<mlir::Operation*, unsigned>> inProgress;
+	};
+}	 // namespace mlir::rlc
@@ -20,6 +20,7 @@ limitations under the License.
 #include "mlir/Dialect/LLVMIR/LLVMDialect.h"
 #include "mlir/IR/BuiltinAttributes.h"
 #include "mlir/IR/BuiltinOps.h"
+#include "mlir/IR/Threading.h"
 #include "mlir/IR/Value.h"
 #include "mlir/Pass/Pass.h"
 #include "mlir/Transforms/DialectConversion.h"
@@ -42,9 +43,16 @@ namespace mlir::rlc
 
 		void runOnOperation() override
 		{
-			ModuleOp module = getOperation();
+			// the checks only use values of the function they are emitted in, so
+			// top level operations are visited in parallel.
+			llvm::SmallVector<mlir::Operation*, 4> toVisit;
+			for (auto& op : *getOperation().getBody())
+				toVisit.push_back(&op);
 
-			module->walk([&](mlir::rlc::ArrayAccess op) { addOutOfBoundsCheck(op); });
+			mlir::parallelForEach(&getContext(), toVisit, [&](mlir::Operation* op) {
+				op->walk(
+						[&](mlir::rlc::ArrayAccess access) { addOutOfBoundsCheck(access); });
+			});
 		}
 
 		void addOutOfBoundsCheck(mlir::rlc::ArrayAccess& op)
@@ -150,6 +150,59 @@ class LowerFree: public mlir::OpConversionPattern<mlir::rlc::FreeOp>
 	}
 };
 
+class LowerRealloc: public mlir::OpConversionPattern<mlir::rlc::ReallocOp>
+{
+	public:
+	LowerRealloc(
+			mlir::TypeConverter& converter,
+			mlir::MLIRContext* ctx,
+			mlir::LLVM::LLVMFuncOp realloc)
+			: mlir::OpConversionPattern<mlir::rlc::ReallocOp>::OpConversionPattern(
+						converter, ctx),
+				realloc(realloc)
+	{
+	}
+	mutable mlir::LLVM::LLVMFuncOp realloc;
+
+	mlir::LogicalResult matchAndRewrite(
+			mlir::rlc::ReallocOp op,
+			OpAdaptor adaptor,
+			mlir::ConversionPatternRewriter& rewriter) const final
+	{
+		auto ptrType = mlir::LLVM::LLVMPointerType::get(getContext());
+		auto ptr =
+				makeAlignedLoad(rewriter, ptrType, adaptor.getArgument(), op.getLoc());
+		mlir::Value loadedCount = makeAlignedLoad(
+				rewriter, rewriter.getI64Type(), adaptor.getSize(), op.getLoc());
+		auto sizeType = realloc.getArgumentTypes()[1];
+		if (loadedCount.getType() != sizeType)
+			loadedCount = rewriter.create<mlir::LLVM::TruncOp>(
+					op.getLoc(), sizeType, loadedCount);
+
+		const auto& dl = mlir::DataLayout::closest(op);
+		auto baseType = typeConverter->convertType(
+				mlir::rlc::ProxyType::get(
+						op.getType().cast<mlir::rlc::OwningPtrType>().getUnderlying()));
+		auto baseSize = rewriter.create<mlir::LLVM::ConstantOp>(
+				op.getLoc(),
+				sizeType,
+				rewriter.getIntegerAttr(sizeType, dl.getTypeSize(baseType)));
+		auto size =
+				rewriter.create<mlir::LLVM::MulOp>(op.getLoc(), loadedCount, baseSize);
+
+		auto newPtr = rewriter.create<mlir::LLVM::CallOp>(
+				op.getLoc(),
+				mlir::TypeRange({ ptrType }),
+				realloc.getSymName(),
+				mlir::ValueRange({ ptr, size }));
+
+		auto alloca = makeAlloca(rewriter, ptrType, op.getLoc());
+		makeAlignedStore(rewriter, newPtr.getResult(), alloca, op.getLoc());
+		rewriter.replaceOp(op, alloca);
+		return mlir::success();
+	}
+};
+
 static mlir::LLVM::ConstantOp lowerConstant(
 		mlir::ConversionPatternRewriter& rewriter,
 		mlir::Attribute attr,
@@ -1293,6 +1346,245 @@ class BuiltinAsPtrRewriter
 	}
 };
 
+// control[index..index+16] == splat(tag) is left to the llvm backend, which
+// selects pcmpeqb + pmovmskb on x86 and cmeq plus a mask reduction on arm.
+class BuiltinMatchGroupRewriter
+		: public mlir::OpConversionPattern<mlir::rlc::BuiltinMatchGroupOp>
+{
+	using mlir::OpConversionPattern<
+			mlir::rlc::BuiltinMatchGroupOp>::OpConversionPattern;
+
+	static constexpr int64_t groupWidth = 16;
+
+	mlir::LogicalResult matchAndRewrite(
+			mlir::rlc::BuiltinMatchGroupOp op,
+			OpAdaptor adaptor,
+			mlir::ConversionPatternRewriter& rewriter) const final
+	{
+		auto loc = op.getLoc();
+		auto ptrType = mlir::LLVM::LLVMPointerType::get(getContext());
+		auto groupType =
+				mlir::VectorType::get({ groupWidth }, rewriter.getI8Type());
+		auto maskType = mlir::VectorType::get({ groupWidth }, rewriter.getI1Type());
+
+		auto control =
+				makeAlignedLoad(rewriter, ptrType, adaptor.getControl(), loc);
+		auto index = makeAlignedLoad(
+				rewriter, rewriter.getI64Type(), adaptor.getIndex(), loc);
+		auto tag =
+				makeAlignedLoad(rewriter, rewriter.getI8Type(), adaptor.getTag(), loc);
+
+		auto address = rewriter.create<mlir::LLVM::GEPOp>(
+				loc,
+				ptrType,
+				rewriter.getI8Type(),
+				control,
+				mlir::ValueRange({ index }));
+		auto group =
+				rewriter.create<mlir::LLVM::LoadOp>(loc, groupType, address, 1);
+
+		auto zero = rewriter.create<mlir::LLVM::ConstantOp>(
+				loc, rewriter.getI32Type(), rewriter.getI32IntegerAttr(0));
+		auto undef = rewriter.create<mlir::LLVM::UndefOp>(loc, groupType);
+		auto inserted =
+				rewriter.create<mlir::LLVM::InsertElementOp>(loc, undef, tag, zero);
+		llvm::SmallVector<int32_t, groupWidth> broadcast(groupWidth, 0);
+		auto splat = rewriter.create<mlir::LLVM::ShuffleVectorOp>(
+				loc, inserted, inserted, broadcast);
+
+		auto equal = rewriter.create<mlir::LLVM::ICmpOp>(
+				loc, maskType, mlir::LLVM::ICmpPredicate::eq, group, splat);
+		auto bits = rewriter.create<mlir::LLVM::BitcastOp>(
+				loc, rewriter.getIntegerType(groupWidth), equal);
+		auto extended =
+				rewriter.create<mlir::LLVM::ZExtOp>(loc, rewriter.getI64Type(), bits);
+
+		auto alloca = makeAlloca(rewriter, rewriter.getI64Type(), loc);
+		makeAlignedStore(rewriter, extended, alloca, loc);
+		rewriter.replaceOp(op, alloca);
+		return mlir::LogicalResult::success();
+	}
+};
+
+// tells if two values of the type are equal exactly when their bytes are, see
+// BuiltinIsPlainDataOp.
+static bool isPlainData(
+		mlir::Type type,
+		const mlir::TypeConverter* converter,
+		const mlir::DataLayout& dl)
+{
+	if (type.isa<mlir::rlc::IntegerType>() or type.isa<mlir::rlc::BoolType>())
+		return true;
+	if (auto array = type.dyn_cast<mlir::rlc::ArrayType>())
+		return isPlainData(array.getUnderlying(), converter, dl);
+
+	auto classType = type.dyn_cast<mlir::rlc::ClassType>();
+	if (not classType)
+		return false;
+	uint64_t membersSize = 0;
+	for (auto member : classType.getMembers())
+	{
+		if (not isPlainData(member.getType(), converter, dl))
+			return false;
+		membersSize += dl.getTypeSize(converter->convertType(
+				mlir::rlc::ProxyType::get(member.getType())));
+	}
+	return membersSize ==
+				 dl.getTypeSize(
+						 converter->convertType(mlir::rlc::ProxyType::get(type)));
+}
+
+class BuiltinIsPlainDataRewriter
+		: public mlir::OpConversionPattern<mlir::rlc::BuiltinIsPlainDataOp>
+{
+	using mlir::OpConversionPattern<
+			mlir::rlc::BuiltinIsPlainDataOp>::OpConversionPattern;
+
+	mlir::LogicalResult matchAndRewrite(
+			mlir::rlc::BuiltinIsPlainDataOp op,
+			OpAdaptor adaptor,
+			mlir::ConversionPatternRewriter& rewriter) const final
+	{
+		bool plain = isPlainData(
+				op.getValue().getType(),
+				typeConverter,
+				mlir::DataLayout::closest(op));
+		auto constant = rewriter.create<mlir::LLVM::ConstantOp>(
+				op.getLoc(),
+				rewriter.getI8Type(),
+				rewriter.getI8IntegerAttr(plain ? 1 : 0));
+		auto alloca = makeAlloca(rewriter, rewriter.getI8Type(), op.getLoc());
+		makeAlignedStore(rewriter, constant, alloca, op.getLoc());
+		rewriter.replaceOp(op, alloca);
+		return mlir::LogicalResult::success();
+	}
+};
+
+class BuiltinSizeOfRewriter
+		: public mlir::OpConversionPattern<mlir::rlc::BuiltinSizeOfOp>
+{
+	using mlir::OpConversionPattern<
+			mlir::rlc::BuiltinSizeOfOp>::OpConversionPattern;
+
+	mlir::LogicalResult matchAndRewrite(
+			mlir::rlc::BuiltinSizeOfOp op,
+			OpAdaptor adaptor,
+			mlir::ConversionPatternRewriter& rewriter) const final
+	{
+		const auto& dl = mlir::DataLayout::closest(op);
+		auto type = typeConverter->convertType(
+				mlir::rlc::ProxyType::get(op.getValue().getType()));
+		auto constant = rewriter.create<mlir::LLVM::ConstantOp>(
+				op.getLoc(),
+				rewriter.getI64Type(),
+				rewriter.getI64IntegerAttr(dl.getTypeSize(type)));
+		auto alloca = makeAlloca(rewriter, rewriter.getI64Type(), op.getLoc());
+		makeAlignedStore(rewriter, constant, alloca, op.getLoc());
+		rewriter.replaceOp(op, alloca);
+		return mlir::LogicalResult::success();
+	}
+};
+
+class BuiltinCopyBytesRewriter
+		: public mlir::OpConversionPattern<mlir::rlc::BuiltinCopyBytesOp>
+{
+	using mlir::OpConversionPattern<
+			mlir::rlc::BuiltinCopyBytesOp>::OpConversionPattern;
+
+	mlir::LogicalResult matchAndRewrite(
+			mlir::rlc::BuiltinCopyBytesOp op,
+			OpAdaptor adaptor,
+			mlir::ConversionPatternRewriter& rewriter) const final
+	{
+		auto size = makeAlignedLoad(
+				rewriter, rewriter.getI64Type(), adaptor.getSize(), op.getLoc());
+		rewriter.replaceOpWithNewOp<mlir::LLVM::MemcpyOp>(
+				op, adaptor.getDestination(), adaptor.getSource(), size, false);
+		return mlir::LogicalResult::success();
+	}
+};
+
+class BuiltinStoreFloat32Rewriter
+		: public mlir::OpConversionPattern<mlir::rlc::BuiltinStoreFloat32Op>
+{
+	using mlir::OpConversionPattern<
+			mlir::rlc::BuiltinStoreFloat32Op>::OpConversionPattern;
+
+	mlir::LogicalResult matchAndRewrite(
+			mlir::rlc::BuiltinStoreFloat32Op op,
+			OpAdaptor adaptor,
+			mlir::ConversionPatternRewriter& rewriter) const final
+	{
+		auto value = makeAlignedLoad(
+				rewriter, rewriter.getF64Type(), adaptor.getValue(), op.getLoc());
+		auto truncated = rewriter.create<mlir::LLVM::FPTruncOp>(
+				op.getLoc(), rewriter.getF32Type(), value);
+		auto bits = rewriter.create<mlir::LLVM::BitcastOp>(
+				op.getLoc(), rewriter.getI32Type(), truncated);
+		// the destination is a byte, so it is only aligned to one
+		rewriter.replaceOpWithNewOp<mlir::LLVM::StoreOp>(
+				op, bits, adaptor.getDestination(), 1);
+		return mlir::LogicalResult::success();
+	}
+};
+
+class BuiltinHashBytesRewriter
+		: public mlir::OpConversionPattern<mlir::rlc::BuiltinHashBytesOp>
+{
+	public:
+	BuiltinHashBytesRewriter(
+			mlir::TypeConverter& converter,
+			mlir::MLIRContext* ctx,
+			mlir::LLVM::LLVMFuncOp hashBytes)
+			: mlir::OpConversionPattern<mlir::rlc::BuiltinHashBytesOp>::
+						OpConversionPattern(converter, ctx),
+				hashBytes(hashBytes)
+	{
+	}
+	mutable mlir::LLVM::LLVMFuncOp hashBytes;
+
+	mlir::LogicalResult matchAndRewrite(
+			mlir::rlc::BuiltinHashBytesOp op,
+			OpAdaptor adaptor,
+			mlir::ConversionPatternRewriter& rewriter) const final
+	{
+		auto loc = op.getLoc();
+		const auto& dl = mlir::DataLayout::closest(op);
+		auto ptrType = mlir::LLVM::LLVMPointerType::get(getContext());
+		auto i64 = rewriter.getI64Type();
+
+		mlir::Value address = adaptor.getValue();
+		mlir::Type hashedType = op.getValue().getType();
+		if (op.getCount())
+		{
+			address = makeAlignedLoad(rewriter, ptrType, address, loc);
+			hashedType =
+					hashedType.cast<mlir::rlc::OwningPtrType>().getUnderlying();
+		}
+
+		mlir::Value size = rewriter.create<mlir::LLVM::ConstantOp>(
+				loc,
+				i64,
+				rewriter.getI64IntegerAttr(dl.getTypeSize(typeConverter->convertType(
+						mlir::rlc::ProxyType::get(hashedType)))));
+		if (op.getCount())
+		{
+			auto count = makeAlignedLoad(rewriter, i64, adaptor.getCount(), loc);
+			size = rewriter.create<mlir::LLVM::MulOp>(loc, count, size);
+		}
+
+		auto hash = rewriter.create<mlir::LLVM::CallOp>(
+				loc,
+				mlir::TypeRange({ i64 }),
+				hashBytes.getSymName(),
+				mlir::ValueRange({ address, size }));
+		auto alloca = makeAlloca(rewriter, i64, loc);
+		makeAlignedStore(rewriter, hash.getResult(), alloca, loc);
+		rewriter.replaceOp(op, alloca);
+		return mlir::LogicalResult::success();
+	}
+};
+
 class UninitializedConstructRewriter
 		: public mlir::OpConversionPattern<mlir::rlc::UninitializedConstruct>
 {
@@ -2275,6 +2567,21 @@ namespace mlir::rlc
 							mlir::LLVM::LLVMPointerType::get(&getContext()),
 							{ rewriter.getIntegerType(dl.getTypeSizeInBits(ptrType)) }));
 
+			auto realloc = rewriter.create<mlir::LLVM::LLVMFuncOp>(
+					getOperation().getLoc(),
+					"realloc",
+					mlir::LLVM::LLVMFunctionType::get(
+							ptrType,
+							{ ptrType,
+								rewriter.getIntegerType(dl.getTypeSizeInBits(ptrType)) }));
+
+			// defined by the runtime library
+			auto hashBytes = rewriter.create<mlir::LLVM::LLVMFuncOp>(
+					getOperation().getLoc(),
+					"rlc_hash_bytes",
+					mlir::LLVM::LLVMFunctionType::get(
+							rewriter.getI64Type(), { ptrType, rewriter.getI64Type() }));
+
 			auto puts = rewriter.create<mlir::LLVM::LLVMFuncOp>(
 					getOperation().getLoc(),
 					"puts",
@@ -2330,6 +2637,7 @@ namespace mlir::rlc
 					.add<InitRewriter>(converter, &getContext())
 					.add<LowerMalloc>(converter, &getContext(), malloc)
 					.add<LowerFree>(converter, &getContext(), free)
+					.add<LowerRealloc>(converter, &getContext(), realloc)
 					.add<LowerStringLiteral>(converter, &getContext(), stringsCache)
 					.add(makeArith(lowerLess, converter, &getContext()))
 					.add(makeArith(lowerLessEqual, converter, &getContext()))
@@ -2371,6 +2679,12 @@ namespace mlir::rlc
 					.add<ReferenceRewriter>(converter, &getContext())
 					.add<UsingTypeEraser>(converter, &getContext())
 					.add<BuiltinAsPtrRewriter>(converter, &getContext())
+					.add<BuiltinMatchGroupRewriter>(converter, &getContext())
+					.add<BuiltinIsPlainDataRewriter>(converter, &getContext())
+					.add<BuiltinSizeOfRewriter>(converter, &getContext())
+					.add<BuiltinCopyBytesRewriter>(converter, &getContext())
+					.add<BuiltinStoreFloat32Rewriter>(converter, &getContext())
+					.add<BuiltinHashBytesRewriter>(converter, &getContext(), hashBytes)
 					.add<LowerIsDoneOp>(converter, &getContext())
 					.add<ClassDeclarationRewriter>(converter, &getContext())
 					.add<ExplicitConstructRewriter>(converter, &getContext())
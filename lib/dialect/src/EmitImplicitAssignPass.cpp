@@ -13,6 +13,7 @@ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
 See the License for the specific language governing permissions and
 limitations under the License.
 */
+#include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "mlir/IR/BuiltinDialect.h"
 #include "rlc/dialect/Operations.hpp"
@@ -61,6 +62,7 @@ namespace mlir::rlc
 						mlir::rlc::FunctionInfoAttr::get(
 								fType.getContext(), { "self", "other" }),
 						true);
+				mlir::rlc::markSynthetic(fun);
 
 				table.add(mlir::rlc::builtinOperatorName<mlir::rlc::AssignOp>(), fun);
 			}
@@ -78,6 +80,7 @@ namespace mlir::rlc
 				mlir::rlc::FunctionInfoAttr::get(
 						fType.getContext(), { "self", "other" }),
 				true);
+		mlir::rlc::markSynthetic(fun);
 
 		table.add(mlir::rlc::builtinOperatorName<mlir::rlc::AssignOp>(), fun);
 		return fun;
@@ -367,21 +370,52 @@ namespace mlir::rlc
 		}
 	}
 
-	static bool isTriviallyCopiable(mlir::Type t)
+	// a type can be copied with a memmove if no type it is made of owns memory
+	// or customizes how it is copied or destroyed. Classes such as most action
+	// frames, made only of integers, bools, floats and arrays of them, are
+	// cloned in a single copy instead of field by field.
+	static bool isTriviallyCopiable(
+			mlir::Type t, const llvm::DenseSet<mlir::Type>& customized)
 	{
-		bool leafesAreAllPrimitiveTypes = true;
-		t.walk([&](mlir::Type inner) {
-			if (inner.isa<mlir::rlc::ClassType>())
-				leafesAreAllPrimitiveTypes = false;
-		});
-		if (t.isa<mlir::rlc::ClassType>())
-			leafesAreAllPrimitiveTypes = false;
+		bool triviallyCopiable = true;
+		auto check = [&](mlir::Type inner) {
+			if (inner.isa<mlir::rlc::OwningPtrType>() or customized.contains(inner))
+				triviallyCopiable = false;
+		};
+		t.walk(check);
+		check(t);
+
+		return triviallyCopiable;
+	}
 
-		return leafesAreAllPrimitiveTypes;
+	// collects the types with a user defined assign or drop. Assign functions
+	// declared by this pass are marked synthetic.
+	static llvm::DenseSet<mlir::Type> collectCustomizedTypes(mlir::ModuleOp op)
+	{
+		llvm::DenseSet<mlir::Type> customized;
+		for (auto fun : op.getOps<mlir::rlc::FunctionOp>())
+		{
+			if (not fun.getIsMemberFunction() or fun.getArgumentTypes().empty())
+				continue;
+
+			auto self = fun.getArgumentTypes().front();
+			if (fun.getUnmangledName() == "drop" and
+					fun.getArgumentTypes().size() == 1)
+				customized.insert(self);
+
+			if (fun.getUnmangledName() ==
+							mlir::rlc::builtinOperatorName<mlir::rlc::AssignOp>() and
+					fun.getArgumentTypes().size() == 2 and
+					fun.getArgumentTypes()[1] == self and not isSynthetic(fun))
+				customized.insert(self);
+		}
+		return customized;
 	}
 
 	static void emitImplicitAssign(
-			mlir::rlc::ModuleBuilder& builder, mlir::rlc::FunctionOp fun)
+			mlir::rlc::ModuleBuilder& builder,
+			mlir::rlc::FunctionOp fun,
+			const llvm::DenseSet<mlir::Type>& customized)
 	{
 		auto& rewriter = builder.getRewriter();
 		if (not fun.getBody().empty())
@@ -404,7 +438,7 @@ namespace mlir::rlc
 		{
 			emitImplicitAssignAlternatveField(builder, fun);
 		}
-		else if (isTriviallyCopiable(lhs))
+		else if (isTriviallyCopiable(lhs, customized))
 		{
 			emitMemMove(builder.getRewriter(), fun);
 		}
@@ -435,9 +469,11 @@ namespace mlir::rlc
 	{
 		mlir::IRRewriter& rewriter = builder.getRewriter();
 
+		auto customized = collectCustomizedTypes(op);
 		for (auto decl : builder.getSymbolTable().get(
 						 mlir::rlc::builtinOperatorName<mlir::rlc::AssignOp>()))
-			emitImplicitAssign(builder, decl.getDefiningOp<mlir::rlc::FunctionOp>());
+			emitImplicitAssign(
+					builder, decl.getDefiningOp<mlir::rlc::FunctionOp>(), customized);
 	}
 
 	mlir::LogicalResult emitImplicitAssign(
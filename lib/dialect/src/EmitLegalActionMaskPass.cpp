@@ -0,0 +1,415 @@
+/*
+Copyright 2024 Massimo Fioravanti
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	 http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/SetVector.h"
+#include "mlir/IR/BuiltinDialect.h"
+#include "mlir/IR/IRMapping.h"
+#include "mlir/IR/PatternMatch.h"
+#include "rlc/dialect/Operations.hpp"
+#include "rlc/dialect/Passes.hpp"
+
+namespace mlir::rlc
+{
+	// the synthetic apply(AnyGameAction self, Game frame) function emitted for
+	// action functions declared with @classes. Actions that take context
+	// arguments have extra parameters and are not handled.
+	static bool isAlternativeApply(mlir::rlc::FunctionOp fun)
+	{
+		if (not isSynthetic(fun) or fun.getUnmangledName() != "apply")
+			return false;
+		if (fun.getArgumentTypes().size() != 2 or fun.getPrecondition().empty())
+			return false;
+		return fun.getArgumentTypes()[0].isa<mlir::rlc::AlternativeType>() and
+					 fun.getArgumentTypes()[1].isa<mlir::rlc::ClassType>();
+	}
+
+	class LegalActionMaskEmitter
+	{
+		public:
+		LegalActionMaskEmitter(
+				mlir::rlc::FunctionOp alternativeApply, mlir::IRRewriter& rewriter)
+				: alternativeApply(alternativeApply),
+					rewriter(rewriter),
+					loc(alternativeApply.getLoc())
+		{
+		}
+
+		// emits legal_action_mask and returns it, or nullptr if the types it
+		// needs have not been instantiated by the program:
+		// fun legal_action_mask(Game frame, Vector<AnyGameAction> actions,
+		// Vector<Byte> out):
+		//   assert(out.size() >= actions.size(), "out of bound vector access")
+		//   let reachable_x = frame.resume_index == r1 or ...
+		//   let i = 0
+		//   while i < actions.size():
+		//     out[i] = 0
+		//     if actions[i] is GameX and reachable_x:
+		//       out[i] = byte(inlined precondition of x)
+		//     ...
+		//     i = i + 1
+		mlir::rlc::FunctionOp emit()
+		{
+			auto* ctx = alternativeApply.getContext();
+			auto alternative = alternativeApply.getArgumentTypes()[0]
+														 .cast<mlir::rlc::AlternativeType>();
+			auto frameType = alternativeApply.getArgumentTypes()[1];
+			auto byteType = mlir::rlc::IntegerType::getInt8(ctx);
+			auto actionsType =
+					mlir::rlc::ClassType::getIdentified(ctx, "Vector", { alternative });
+			auto outType =
+					mlir::rlc::ClassType::getIdentified(ctx, "Vector", { byteType });
+
+			// we can only refer to vectors the program already instantiated,
+			// templates have been expanded already at this point.
+			if (not actionsType.isInitialized() or not outType.isInitialized())
+				return nullptr;
+
+			llvm::SmallVector<std::pair<mlir::Type, mlir::rlc::FunctionOp>, 4>
+					alternatives;
+			if (collectStatementWrappers(alternative, alternatives).failed())
+				return nullptr;
+
+			rewriter.setInsertionPoint(alternativeApply);
+			auto ftype = mlir::FunctionType::get(
+					ctx, { frameType, actionsType, outType }, {});
+			auto fun = rewriter.create<mlir::rlc::FunctionOp>(
+					loc,
+					"legal_action_mask",
+					ftype,
+					mlir::rlc::FunctionInfoAttr::get(
+							ctx, { "frame", "actions", "out" }),
+					false);
+			mlir::rlc::markSynthetic(fun);
+
+			auto* block = rewriter.createBlock(
+					&fun.getBody(),
+					fun.getBody().begin(),
+					ftype.getInputs(),
+					{ loc, loc, loc });
+			rewriter.setInsertionPointToStart(block);
+			frame = block->getArgument(0);
+			auto actions = block->getArgument(1);
+			auto out = block->getArgument(2);
+
+			// get_valid_actions fails when out is shorter than actions, rather
+			// than leaving the mask of the last actions unwritten
+			auto outSize = rewriter.create<mlir::rlc::MemberAccess>(loc, out, 1);
+			auto actionsSize =
+					rewriter.create<mlir::rlc::MemberAccess>(loc, actions, 1);
+			rewriter.create<mlir::rlc::AssertOp>(
+					loc,
+					rewriter.create<mlir::rlc::GreaterEqualOp>(loc, outSize, actionsSize),
+					"out of bound vector access");
+
+			resumeIndex = rewriter.create<mlir::rlc::MemberAccess>(loc, frame, 0);
+
+			// whether the action can be executed at all at the current resumption
+			// point does not depend on the action arguments, so we test it once
+			// for each action statement out of the loop.
+			llvm::SmallVector<mlir::Value, 4> reachable;
+			for (auto& entry : alternatives)
+				reachable.push_back(emitReachable(entry.second));
+
+			auto index = rewriter.create<mlir::rlc::UninitializedConstruct>(
+					loc, mlir::rlc::IntegerType::getInt64(ctx));
+			auto zero =
+					rewriter.create<mlir::rlc::Constant>(loc, static_cast<int64_t>(0));
+			rewriter.create<mlir::rlc::BuiltinAssignOp>(loc, index, zero);
+
+			auto whileStm = rewriter.create<mlir::rlc::WhileStatement>(loc);
+			auto* wCond = rewriter.createBlock(&whileStm.getCondition());
+			rewriter.setInsertionPoint(wCond, wCond->begin());
+			auto cond = rewriter.create<mlir::rlc::LessOp>(
+					loc,
+					index,
+					rewriter.create<mlir::rlc::MemberAccess>(loc, actions, 1));
+			rewriter.create<mlir::rlc::Yield>(loc, mlir::ValueRange({ cond }));
+
+			auto* wBody = rewriter.createBlock(&whileStm.getBody());
+			rewriter.setInsertionPoint(wBody, wBody->begin());
+			auto action = rewriter.create<mlir::rlc::ArrayAccess>(
+					loc, rewriter.create<mlir::rlc::MemberAccess>(loc, actions, 0), index);
+			auto outElement = rewriter.create<mlir::rlc::ArrayAccess>(
+					loc, rewriter.create<mlir::rlc::MemberAccess>(loc, out, 0), index);
+			rewriter.create<mlir::rlc::BuiltinAssignOp>(
+					loc,
+					outElement,
+					rewriter.create<mlir::rlc::Constant>(
+							loc,
+							byteType,
+							rewriter.getIntegerAttr(rewriter.getIntegerType(8), 0)));
+
+			for (auto [entry, isReachable] : llvm::zip(alternatives, reachable))
+				emitActionCheck(
+						action, outElement, entry.first, entry.second, isReachable);
+
+			auto one =
+					rewriter.create<mlir::rlc::Constant>(loc, static_cast<int64_t>(1));
+			auto added = rewriter.create<mlir::rlc::AddOp>(loc, index, one);
+			rewriter.create<mlir::rlc::BuiltinAssignOp>(loc, index, added);
+			rewriter.create<mlir::rlc::Yield>(loc);
+
+			rewriter.setInsertionPointToEnd(block);
+			rewriter.create<mlir::rlc::Yield>(loc, mlir::ValueRange());
+			return fun;
+		}
+
+		private:
+		mlir::rlc::FunctionOp alternativeApply;
+		mlir::IRRewriter& rewriter;
+		mlir::Location loc;
+		mlir::Value frame;
+		mlir::Value resumeIndex;
+		// frame.resume_index == constant, shared by all statements that can
+		// be executed at the same resumption point
+		llvm::DenseMap<int64_t, mlir::Value> resumeChecks;
+
+		// pairs each member of the alternative with the statement wrapper whose
+		// precondition decides if that action can be executed
+		mlir::LogicalResult collectStatementWrappers(
+				mlir::rlc::AlternativeType alternative,
+				llvm::SmallVectorImpl<std::pair<mlir::Type, mlir::rlc::FunctionOp>>&
+						out)
+		{
+			alternativeApply.getPrecondition().walk([&](mlir::rlc::CanOp canOp) {
+				auto applyFunction = getCanCallee(canOp);
+				if (not applyFunction)
+					return;
+				auto wrapper = findStatementWrapper(applyFunction);
+				if (not wrapper)
+					return;
+				out.emplace_back(applyFunction.getArgumentTypes()[0], wrapper);
+			});
+
+			if (out.size() != alternative.getUnderlying().size())
+				return mlir::failure();
+
+			for (auto& entry : out)
+			{
+				auto classType = entry.first.dyn_cast<mlir::rlc::ClassType>();
+				if (not classType)
+					return mlir::failure();
+				auto& precondition = entry.second.getPrecondition();
+				if (not precondition.hasOneBlock() or
+						precondition.front().getNumArguments() !=
+								classType.getMembers().size() + 1)
+					return mlir::failure();
+			}
+			return mlir::success();
+		}
+
+		static std::optional<int64_t> getResumeCheckConstant(
+				mlir::rlc::EqualOp op)
+		{
+			auto access = op.getLhs().getDefiningOp<mlir::rlc::MemberAccess>();
+			if (not access or access.getMemberIndex() != 0 or
+					not access.getValue().isa<mlir::BlockArgument>() or
+					access.getValue().cast<mlir::BlockArgument>().getArgNumber() != 0)
+				return std::nullopt;
+			auto constant = op.getRhs().getDefiningOp<mlir::rlc::Constant>();
+			if (not constant)
+				return std::nullopt;
+			auto attr = constant.getValue().dyn_cast<mlir::IntegerAttr>();
+			if (not attr)
+				return std::nullopt;
+			return attr.getInt();
+		}
+
+		mlir::Value getResumeCheck(int64_t resumptionPoint)
+		{
+			auto& check = resumeChecks[resumptionPoint];
+			if (check)
+				return check;
+
+			auto expected = rewriter.create<mlir::rlc::Constant>(
+					loc, static_cast<int64_t>(resumptionPoint));
+			check = rewriter.create<mlir::rlc::EqualOp>(loc, resumeIndex, expected);
+			return check;
+		}
+
+		// collects the resumption points tested by the precondition of a
+		// statement wrapper. Occurrences without a user precondition test it at
+		// the top level, the others in the lhs of a short circuiting and.
+		static void collectResumptionPoints(
+				mlir::rlc::FunctionOp wrapper, llvm::SetVector<int64_t>& out)
+		{
+			auto collect = [&](mlir::Block& block) {
+				for (auto eq : block.getOps<mlir::rlc::EqualOp>())
+					if (auto resumptionPoint = getResumeCheckConstant(eq))
+						out.insert(*resumptionPoint);
+			};
+
+			auto& precondition = wrapper.getPrecondition().front();
+			collect(precondition);
+			for (auto andOp : precondition.getOps<mlir::rlc::ShortCircuitingAnd>())
+				collect(andOp.getLhs().front());
+		}
+
+		// emits the or of all the resumption points at which the statement
+		// wrapper can be invoked
+		mlir::Value emitReachable(mlir::rlc::FunctionOp wrapper)
+		{
+			llvm::SetVector<int64_t> resumptionPoints;
+			collectResumptionPoints(wrapper, resumptionPoints);
+
+			mlir::Value result = nullptr;
+			for (auto resumptionPoint : resumptionPoints)
+			{
+				auto check = getResumeCheck(resumptionPoint);
+				result = result == nullptr
+										 ? check
+										 : rewriter.create<mlir::rlc::OrOp>(loc, result, check);
+			}
+
+			if (result == nullptr)
+				return rewriter.create<mlir::rlc::Constant>(loc, true);
+			return result;
+		}
+
+		// emits
+		// if action is GameX and reachable:
+		//   out[i] = byte(inlined precondition)
+		void emitActionCheck(
+				mlir::Value action,
+				mlir::Value outElement,
+				mlir::Type actionType,
+				mlir::rlc::FunctionOp wrapper,
+				mlir::Value reachable)
+		{
+			auto ifStatement = rewriter.create<mlir::rlc::IfStatement>(loc);
+			auto* condition = rewriter.createBlock(&ifStatement.getCondition());
+			auto isOp = rewriter.create<mlir::rlc::IsOp>(loc, action, actionType);
+			auto cond = rewriter.create<mlir::rlc::AndOp>(loc, isOp, reachable);
+			rewriter.create<mlir::rlc::Yield>(loc, mlir::ValueRange({ cond }));
+
+			rewriter.createBlock(&ifStatement.getTrueBranch());
+			auto upcasted =
+					rewriter.create<mlir::rlc::ValueUpcastOp>(loc, actionType, action);
+
+			auto& precondition = wrapper.getPrecondition().front();
+			mlir::IRMapping mapping;
+			mapping.map(precondition.getArgument(0), frame);
+			for (auto arg : llvm::drop_begin(precondition.getArguments()))
+			{
+				auto member = rewriter.create<mlir::rlc::MemberAccess>(
+						loc, upcasted, arg.getArgNumber() - 1);
+				mapping.map(arg, member);
+			}
+
+			for (auto& op : precondition.without_terminator())
+			{
+				// the resumption point has already been tested out of the loop,
+				// and reading it again is just noise for the optimizer
+				if (auto eq = mlir::dyn_cast<mlir::rlc::EqualOp>(op))
+				{
+					if (auto point = getResumeCheckConstant(eq))
+					{
+						mapping.map(eq.getResult(), resumeChecks[*point]);
+						continue;
+					}
+				}
+				if (auto access = mlir::dyn_cast<mlir::rlc::MemberAccess>(op);
+						access and access.getValue() == precondition.getArgument(0) and
+						access.getMemberIndex() == 0)
+				{
+					mapping.map(access.getResult(), resumeIndex);
+					continue;
+				}
+				rewriter.clone(op, mapping);
+			}
+
+			mlir::Value result = rewriter.create<mlir::rlc::Constant>(loc, true);
+			for (auto value : precondition.getTerminator()->getOperands())
+				result = rewriter.create<mlir::rlc::AndOp>(
+						loc, result, mapping.lookupOrDefault(value));
+
+			auto casted = rewriter.create<mlir::rlc::CastOp>(
+					loc, result, mlir::rlc::IntegerType::getInt8(action.getContext()));
+			rewriter.create<mlir::rlc::BuiltinAssignOp>(loc, outElement, casted);
+			rewriter.create<mlir::rlc::Yield>(loc);
+
+			rewriter.createBlock(&ifStatement.getElseBranch());
+			rewriter.create<mlir::rlc::Yield>(loc);
+			rewriter.setInsertionPointAfter(ifStatement);
+		}
+	};
+
+	// get_valid_actions(Vector<Byte>, Vector<AnyGameAction>, Game) is what
+	// the stdlib and the python environments use to compute the mask, so the
+	// instantiations that match the fused function are rewritten to just
+	// forward to it.
+	static void forwardGetValidActions(
+			mlir::ModuleOp module,
+			mlir::rlc::FunctionOp mask,
+			mlir::IRRewriter& rewriter)
+	{
+		auto maskTypes = mask.getArgumentTypes();
+		for (auto fun : module.getOps<mlir::rlc::FunctionOp>())
+		{
+			if (fun.getUnmangledName() != "get_valid_actions" or
+					fun.isDeclaration() or fun.getResultTypes().size() != 0)
+				continue;
+
+			auto types = fun.getArgumentTypes();
+			if (types.size() != 3 or types[0] != maskTypes[2] or
+					types[1] != maskTypes[1] or types[2] != maskTypes[0])
+				continue;
+
+			fun.getBody().dropAllReferences();
+			fun.getBody().getBlocks().clear();
+			auto* block = rewriter.createBlock(
+					&fun.getBody(),
+					fun.getBody().begin(),
+					types,
+					{ fun.getLoc(), fun.getLoc(), fun.getLoc() });
+			rewriter.setInsertionPointToStart(block);
+			rewriter.create<mlir::rlc::CallOp>(
+					fun.getLoc(),
+					mask.getResult(),
+					false,
+					mlir::ValueRange({ block->getArgument(2),
+														 block->getArgument(1),
+														 block->getArgument(0) }));
+			rewriter.create<mlir::rlc::Yield>(fun.getLoc(), mlir::ValueRange());
+		}
+	}
+
+#define GEN_PASS_DEF_EMITLEGALACTIONMASKPASS
+#include "rlc/dialect/Passes.inc"
+
+	struct EmitLegalActionMaskPass
+			: impl::EmitLegalActionMaskPassBase<EmitLegalActionMaskPass>
+	{
+		using impl::EmitLegalActionMaskPassBase<
+				EmitLegalActionMaskPass>::EmitLegalActionMaskPassBase;
+
+		void runOnOperation() override
+		{
+			llvm::SmallVector<mlir::rlc::FunctionOp, 2> ops;
+			for (auto fun : getOperation().getOps<mlir::rlc::FunctionOp>())
+				if (isAlternativeApply(fun))
+					ops.push_back(fun);
+
+			mlir::IRRewriter rewriter(&getContext());
+			for (auto fun : ops)
+			{
+				LegalActionMaskEmitter emitter(fun, rewriter);
+				if (auto mask = emitter.emit())
+					forwardGetValidActions(getOperation(), mask, rewriter);
+			}
+		}
+	};
+}	 // namespace mlir::rlc
@@ -35,8 +35,6 @@ namespace mlir::rlc
 
 			for (auto op : toHoist)
 			{
-				auto parent = op->getParentOfType<mlir::LLVM::LLVMFuncOp>();
-				assert(parent != nullptr);
 				op->moveAfter(op.getArraySize().getDefiningOp());
 			}
 		}
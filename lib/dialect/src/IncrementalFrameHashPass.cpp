@@ -0,0 +1,481 @@
+/*
+Copyright 2024 Massimo Fioravanti
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	 http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/DenseSet.h"
+#include "mlir/IR/BuiltinDialect.h"
+#include "mlir/IR/PatternMatch.h"
+#include "rlc/dialect/Operations.hpp"
+#include "rlc/dialect/Passes.hpp"
+#include "rlc/dialect/ReadOnlyUses.hpp"
+
+// Incremental hashing of action frames works in three steps:
+//
+// - before type checking each action function gets a hidden frame variable
+// _frame_hash and a declaration of fun hash(Frame) -> Int.
+// - before templates are instantiated hash(Frame) is defined as the xor of
+// _frame_hash with the contribution of every field, computed from scratch.
+// - once actions have been lowered to plain functions, the integer and bool
+// fields whose every store is visible to the compiler are tracked: each store
+// updates _frame_hash zobrist style, xoring out the contribution of the old
+// value and xoring in the one of the new value, and their contribution is
+// removed from hash(Frame). If every field is tracked hash(Frame) is O(1).
+//
+// A field stops being tracked as soon as a reference to it escapes somewhere
+// the compiler can't tell it is only read, so the result of hash(Frame) is
+// the same no matter how many fields end up being tracked. Writes performed
+// by foreign code through the generated wrappers are not seen.
+namespace mlir::rlc
+{
+	static constexpr llvm::StringLiteral frameHashMember = "_frame_hash";
+	static constexpr llvm::StringLiteral frameHashMixFunction = "_frame_hash_mix";
+	static constexpr llvm::StringLiteral hashedFieldAttr = "rlc.hashed_field";
+
+	static std::optional<size_t> frameHashIndex(mlir::rlc::ClassType type)
+	{
+		for (auto field : llvm::enumerate(type.getMembers()))
+			if (field.value().getName() == frameHashMember)
+				return field.index();
+		return std::nullopt;
+	}
+
+	// fields whose stores can be instrumented, resume_index is excluded because
+	// it is written by ActionStatementsToCoro, which runs after us.
+	static bool isTrackableField(mlir::rlc::ClassType type, size_t index)
+	{
+		if (index == 0 or index == frameHashIndex(type))
+			return false;
+		auto fieldType = type.getMembers()[index].getType();
+		return fieldType.isa<mlir::rlc::IntegerType>() or
+					 fieldType.isa<mlir::rlc::BoolType>();
+	}
+
+	// the hash(Frame) functions declared by DeclareFrameHashPass, associated to
+	// the frame they hash.
+	using FrameHashFunctions = llvm::SmallVector<
+			std::pair<mlir::rlc::ClassType, mlir::rlc::FunctionOp>,
+			2>;
+	static FrameHashFunctions frameHashFunctions(mlir::ModuleOp module)
+	{
+		FrameHashFunctions toReturn;
+		for (auto fun : module.getOps<mlir::rlc::FunctionOp>())
+		{
+			if (not isSynthetic(fun) or fun.getUnmangledName() != "hash" or
+					fun.getArgumentTypes().size() != 1)
+				continue;
+			auto type = fun.getArgumentTypes()[0].dyn_cast<mlir::rlc::ClassType>();
+			if (type and frameHashIndex(type))
+				toReturn.emplace_back(type, fun);
+		}
+		return toReturn;
+	}
+
+	static mlir::rlc::FunctionOp findMixFunction(mlir::ModuleOp module)
+	{
+		for (auto fun : module.getOps<mlir::rlc::FunctionOp>())
+			if (isSynthetic(fun) and fun.getUnmangledName() == frameHashMixFunction)
+				return fun;
+		return nullptr;
+	}
+
+	// emits the contribution of a single field to the hash of a frame:
+	// _frame_hash_mix(index, int(frame.field))
+	static mlir::Value emitFieldContribution(
+			mlir::IRRewriter& rewriter,
+			mlir::Location loc,
+			mlir::rlc::FunctionOp mix,
+			int64_t index,
+			mlir::Value value)
+	{
+		auto intType = mlir::rlc::IntegerType::getInt64(rewriter.getContext());
+		auto constant = rewriter.create<mlir::rlc::Constant>(loc, index);
+		if (value.getType() != intType)
+			value = rewriter.create<mlir::rlc::CastOp>(loc, value, intType);
+		auto call = rewriter.create<mlir::rlc::CallOp>(
+				loc, mix.getResult(), false, mlir::ValueRange({ constant, value }));
+		return call.getResult(0);
+	}
+
+	static void eraseIfDead(mlir::IRRewriter& rewriter, mlir::Operation* op)
+	{
+		if (op == nullptr or not op->use_empty() or
+				mlir::isa<mlir::rlc::FunctionOp>(op))
+			return;
+		llvm::SmallVector<mlir::Operation*, 2> operands;
+		for (auto operand : op->getOperands())
+			operands.push_back(operand.getDefiningOp());
+		rewriter.eraseOp(op);
+		for (auto* operand : operands)
+			eraseIfDead(rewriter, operand);
+	}
+
+#define GEN_PASS_DEF_DECLAREFRAMEHASHPASS
+#include "rlc/dialect/Passes.inc"
+
+	struct DeclareFrameHashPass
+			: impl::DeclareFrameHashPassBase<DeclareFrameHashPass>
+	{
+		void runOnOperation() override
+		{
+			mlir::IRRewriter rewriter(&getContext());
+			auto* ctx = &getContext();
+			llvm::SmallVector<mlir::rlc::ActionFunction, 4> actions(
+					getOperation().getOps<mlir::rlc::ActionFunction>());
+			for (auto action : actions)
+			{
+				// actions without a declared return type have no name the
+				// declaration of hash can refer to
+				auto frameType = action.getFunctionType().getResult(0);
+				if (auto casted = frameType.dyn_cast<mlir::rlc::ClassType>();
+						casted and casted.getName().empty())
+					continue;
+
+				// frm _frame_hash = 0
+				rewriter.setInsertionPointToStart(&action.getBody().front());
+				auto decl = rewriter.create<mlir::rlc::DeclarationStatement>(
+						action.getLoc(),
+						mlir::rlc::FrameType::get(mlir::rlc::UnknownType::get(ctx)),
+						frameHashMember);
+				markSynthetic(decl);
+				rewriter.createBlock(&decl.getBody());
+				auto zero =
+						rewriter.create<mlir::rlc::Constant>(action.getLoc(), int64_t(0));
+				rewriter.create<mlir::rlc::Yield>(
+						action.getLoc(), mlir::ValueRange({ zero }));
+
+				// fun hash(Frame frame) -> Int
+				rewriter.setInsertionPointAfter(action);
+				auto ftype = mlir::FunctionType::get(
+						ctx,
+						{ frameType },
+						{ mlir::rlc::IntegerType::getInt64(ctx) });
+				auto fun = rewriter.create<mlir::rlc::FunctionOp>(
+						action.getLoc(),
+						"hash",
+						ftype,
+						mlir::rlc::FunctionInfoAttr::get(ctx, { "frame" }),
+						false);
+				markSynthetic(fun);
+			}
+		}
+	};
+
+#define GEN_PASS_DEF_EMITFRAMEHASHPASS
+#include "rlc/dialect/Passes.inc"
+
+	struct EmitFrameHashPass: impl::EmitFrameHashPassBase<EmitFrameHashPass>
+	{
+		void runOnOperation() override
+		{
+			auto hashFunctions = frameHashFunctions(getOperation());
+			if (hashFunctions.empty())
+				return;
+
+			mlir::rlc::ModuleBuilder builder(getOperation());
+			auto& rewriter = builder.getRewriter();
+			auto mix = emitMixFunction(rewriter, hashFunctions.front().second);
+
+			for (auto [type, fun] : hashFunctions)
+			{
+				if (not fun.isDeclaration())
+					continue;
+				if (emitHashFunction(builder, mix, type, fun).failed())
+				{
+					signalPassFailure();
+					return;
+				}
+			}
+		}
+
+		private:
+		// fun _frame_hash_mix(Int field, Int value) -> Int, the splitmix64
+		// finalizer applied to the value salted with the field index.
+		mlir::rlc::FunctionOp emitMixFunction(
+				mlir::IRRewriter& rewriter, mlir::Operation* insertionPoint)
+		{
+			auto* ctx = &getContext();
+			auto loc = insertionPoint->getLoc();
+			auto intType = mlir::rlc::IntegerType::getInt64(ctx);
+			rewriter.setInsertionPoint(insertionPoint);
+			auto ftype =
+					mlir::FunctionType::get(ctx, { intType, intType }, { intType });
+			auto fun = rewriter.create<mlir::rlc::FunctionOp>(
+					loc,
+					frameHashMixFunction,
+					ftype,
+					mlir::rlc::FunctionInfoAttr::get(ctx, { "field", "value" }),
+					false);
+			markSynthetic(fun);
+
+			auto* block = rewriter.createBlock(
+					&fun.getBody(),
+					fun.getBody().begin(),
+					ftype.getInputs(),
+					{ loc, loc });
+			rewriter.setInsertionPointToStart(block);
+
+			auto constant = [&](int64_t value) -> mlir::Value {
+				return rewriter.create<mlir::rlc::Constant>(loc, value);
+			};
+			auto xorShift = [&](mlir::Value value, int64_t amount) -> mlir::Value {
+				auto shifted = rewriter.create<mlir::rlc::RightShiftOp>(
+						loc, value, constant(amount));
+				return rewriter.create<mlir::rlc::BitXorOp>(loc, value, shifted);
+			};
+
+			mlir::Value salt = rewriter.create<mlir::rlc::MultOp>(
+					loc, block->getArgument(0), constant(-7046029254386353131));
+			mlir::Value x = rewriter.create<mlir::rlc::BitXorOp>(
+					loc, block->getArgument(1), salt);
+			x = xorShift(x, 30);
+			x = rewriter.create<mlir::rlc::MultOp>(
+					loc, x, constant(-4658895280553007687));
+			x = xorShift(x, 27);
+			x = rewriter.create<mlir::rlc::MultOp>(
+					loc, x, constant(-7723592293110705685));
+			x = xorShift(x, 31);
+
+			auto ret = rewriter.create<mlir::rlc::ReturnStatement>(loc, intType);
+			rewriter.createBlock(&ret.getBody());
+			rewriter.create<mlir::rlc::Yield>(loc, mlir::ValueRange({ x }));
+			return fun;
+		}
+
+		// fun hash(Frame frame) -> Int:
+		//   return frame._frame_hash ^ _frame_hash_mix(0, frame.resume_index) ^
+		//          _frame_hash_mix(1, compute_hash_of(frame.field1)) ^ ...
+		// every xor is tagged with the index of the field it adds, so that
+		// IncrementalFrameHashPass can drop the ones of the tracked fields.
+		mlir::LogicalResult emitHashFunction(
+				mlir::rlc::ModuleBuilder& builder,
+				mlir::rlc::FunctionOp mix,
+				mlir::rlc::ClassType type,
+				mlir::rlc::FunctionOp fun)
+		{
+			auto& rewriter = builder.getRewriter();
+			auto loc = fun.getLoc();
+			auto hashIndex = *frameHashIndex(type);
+			auto* block = rewriter.createBlock(
+					&fun.getBody(),
+					fun.getBody().begin(),
+					fun.getFunctionType().getInputs(),
+					{ loc });
+			rewriter.setInsertionPointToStart(block);
+			auto frame = block->getArgument(0);
+
+			mlir::Value result =
+					rewriter.create<mlir::rlc::MemberAccess>(loc, frame, hashIndex);
+			for (auto field : llvm::enumerate(type.getMembers()))
+			{
+				if (field.index() == hashIndex)
+					continue;
+				mlir::Value value = rewriter.create<mlir::rlc::MemberAccess>(
+						loc, frame, field.index());
+				auto fieldType = field.value().getType();
+				if (not fieldType.isa<mlir::rlc::IntegerType>() and
+						not fieldType.isa<mlir::rlc::BoolType>())
+				{
+					auto* call = builder.emitCall(
+							fun,
+							false,
+							"compute_hash_of",
+							mlir::ValueRange({ value }),
+							false);
+					if (call == nullptr)
+						return mlir::rlc::logError(
+								fun,
+								"--incremental-hash requires serialization.to_hash to be "
+								"imported to hash field " +
+										field.value().getName().str() + " of " +
+										prettyType(type));
+					value = call->getResult(0);
+				}
+				auto contribution =
+						emitFieldContribution(rewriter, loc, mix, field.index(), value);
+				auto xorOp =
+						rewriter.create<mlir::rlc::BitXorOp>(loc, result, contribution);
+				xorOp->setAttr(
+						hashedFieldAttr, rewriter.getI64IntegerAttr(field.index()));
+				result = xorOp;
+			}
+
+			auto ret = rewriter.create<mlir::rlc::ReturnStatement>(
+					loc, fun.getFunctionType().getResult(0));
+			rewriter.createBlock(&ret.getBody());
+			rewriter.create<mlir::rlc::Yield>(loc, mlir::ValueRange({ result }));
+			return mlir::success();
+		}
+	};
+
+#define GEN_PASS_DEF_INCREMENTALFRAMEHASHPASS
+#include "rlc/dialect/Passes.inc"
+
+	struct IncrementalFrameHashPass
+			: impl::IncrementalFrameHashPassBase<IncrementalFrameHashPass>
+	{
+		void runOnOperation() override
+		{
+			auto mix = findMixFunction(getOperation());
+			if (not mix)
+				return;
+
+			mlir::IRRewriter rewriter(&getContext());
+			for (auto [type, fun] : frameHashFunctions(getOperation()))
+				trackFields(rewriter, mix, type, fun);
+		}
+
+		private:
+		void trackFields(
+				mlir::IRRewriter& rewriter,
+				mlir::rlc::FunctionOp mix,
+				mlir::rlc::ClassType type,
+				mlir::rlc::FunctionOp hashFunction)
+		{
+			auto hashIndex = *frameHashIndex(type);
+			eraseInitialization(rewriter, type, hashIndex);
+
+			llvm::SmallVector<mlir::rlc::MemberAccess, 8> accesses;
+			getOperation().walk([&](mlir::rlc::MemberAccess access) {
+				if (access.getValue().getType() == type and
+						not hashFunction->isAncestor(access))
+					accesses.push_back(access);
+			});
+
+			// functions that write the hash itself, such as the implicit init and
+			// assign of the frame, or anything iterating over all of its fields,
+			// handle the object as a whole and keep the hash consistent on their
+			// own.
+			llvm::DenseSet<mlir::Operation*> wholeObjectFunctions;
+			for (auto access : accesses)
+			{
+				if (access.getMemberIndex() != hashIndex)
+					continue;
+				for (auto& use : access.getResult().getUses())
+					if (not readOnlyUses.isReadOnly(use))
+						wholeObjectFunctions.insert(
+								access->getParentOfType<mlir::rlc::FunctionOp>());
+			}
+
+			llvm::DenseMap<int64_t, llvm::SmallVector<mlir::rlc::BuiltinAssignOp, 4>>
+					stores;
+			llvm::DenseSet<int64_t> untracked;
+			for (auto access : accesses)
+			{
+				auto index = access.getMemberIndex();
+				if (not isTrackableField(type, index) or
+						wholeObjectFunctions.contains(
+								access->getParentOfType<mlir::rlc::FunctionOp>()))
+					continue;
+
+				for (auto& use : access.getResult().getUses())
+				{
+					auto store =
+							mlir::dyn_cast<mlir::rlc::BuiltinAssignOp>(use.getOwner());
+					if (store and use.getOperandNumber() == 0)
+						stores[index].push_back(store);
+					else if (not readOnlyUses.isReadOnly(use))
+						untracked.insert(index);
+				}
+			}
+
+			for (auto field : llvm::enumerate(type.getMembers()))
+			{
+				int64_t index = field.index();
+				if (not isTrackableField(type, index) or untracked.contains(index))
+					continue;
+
+				for (auto store : stores[index])
+					instrumentStore(rewriter, mix, store, index, hashIndex);
+				dropContribution(rewriter, hashFunction, index);
+			}
+		}
+
+		// the hash starts from zero when the frame is constructed, it must not be
+		// reset again when the action body starts, after arguments have been
+		// stored in the frame already.
+		void eraseInitialization(
+				mlir::IRRewriter& rewriter, mlir::rlc::ClassType type, size_t hashIndex)
+		{
+			llvm::SmallVector<mlir::rlc::BuiltinAssignOp, 2> initializations;
+			getOperation().walk([&](mlir::rlc::BuiltinAssignOp store) {
+				auto access = store.getLhs().getDefiningOp<mlir::rlc::MemberAccess>();
+				auto decl =
+						store.getRhs().getDefiningOp<mlir::rlc::DeclarationStatement>();
+				if (access and decl and access.getValue().getType() == type and
+						access.getMemberIndex() == hashIndex and
+						decl.getSymName() == frameHashMember)
+					initializations.push_back(store);
+			});
+
+			for (auto store : initializations)
+			{
+				auto* access = store.getLhs().getDefiningOp();
+				rewriter.eraseOp(store);
+				eraseIfDead(rewriter, access);
+			}
+		}
+
+		// frame.field = value becomes
+		// let old = _frame_hash_mix(index, int(frame.field))
+		// frame.field = value
+		// frame._frame_hash = frame._frame_hash ^ old ^
+		//   _frame_hash_mix(index, int(frame.field))
+		void instrumentStore(
+				mlir::IRRewriter& rewriter,
+				mlir::rlc::FunctionOp mix,
+				mlir::rlc::BuiltinAssignOp store,
+				int64_t index,
+				size_t hashIndex)
+		{
+			auto loc = store.getLoc();
+			auto access = store.getLhs().getDefiningOp<mlir::rlc::MemberAccess>();
+
+			rewriter.setInsertionPoint(store);
+			auto oldContribution =
+					emitFieldContribution(rewriter, loc, mix, index, access);
+
+			rewriter.setInsertionPointAfter(store);
+			auto newContribution =
+					emitFieldContribution(rewriter, loc, mix, index, access);
+			auto delta = rewriter.create<mlir::rlc::BitXorOp>(
+					loc, oldContribution, newContribution);
+			auto hash = rewriter.create<mlir::rlc::MemberAccess>(
+					loc, access.getValue(), hashIndex);
+			auto updated = rewriter.create<mlir::rlc::BitXorOp>(loc, hash, delta);
+			rewriter.create<mlir::rlc::BuiltinAssignOp>(loc, hash, updated);
+		}
+
+		void dropContribution(
+				mlir::IRRewriter& rewriter,
+				mlir::rlc::FunctionOp hashFunction,
+				int64_t index)
+		{
+			mlir::rlc::BitXorOp toDrop = nullptr;
+			hashFunction.walk([&](mlir::rlc::BitXorOp op) {
+				auto attr = op->getAttrOfType<mlir::IntegerAttr>(hashedFieldAttr);
+				if (attr and attr.getInt() == index)
+					toDrop = op;
+			});
+			if (not toDrop)
+				return;
+
+			auto* contribution = toDrop.getRhs().getDefiningOp();
+			rewriter.replaceOp(toDrop, toDrop.getLhs());
+			eraseIfDead(rewriter, contribution);
+		}
+
+		ReadOnlyUses readOnlyUses;
+	};
+}	 // namespace mlir::rlc
@@ -0,0 +1,472 @@
+/*
+Copyright 2024 Massimo Fioravanti
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	 http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "llvm/ADT/DenseSet.h"
+#include "mlir/IR/BuiltinDialect.h"
+#include "mlir/IR/PatternMatch.h"
+#include "rlc/dialect/Operations.hpp"
+#include "rlc/dialect/Passes.hpp"
+#include "rlc/dialect/ReadOnlyUses.hpp"
+
+// Incremental observation tensors let a environment keep the tensor of a game
+// up to date rewriting only the fields that changed since the last time it was
+// written:
+//
+// let tensor : Vector<Float>
+// tensor.resize(observation_tensor_size(game))
+// update_observation_tensor(game, 0, tensor)
+// apply(action, game)
+// update_observation_tensor(game, 0, tensor)
+//
+// They are built in three steps:
+//
+// - before type checking each action function gets a hidden frame variable
+// _observation_dirty, initialized to -1, and a declaration of
+// update_observation_tensor(Frame, Int, Vector<Float>).
+// - before templates are instantiated update_observation_tensor is defined as
+// rewriting the regions of the fields whose bit is set in _observation_dirty,
+// and then clearing it. Field i maps to bit i % 63.
+// - once actions have been lowered to plain functions, every member access
+// to a frame that may write the field sets the bit of that field, and every
+// operation that may write the frame as a whole sets them all. Fields a
+// reference to which is stored somewhere, such as the context arguments of
+// actions, are rewritten by every update, since the writes through the stored
+// reference are not seen.
+//
+// The tensor passed to update_observation_tensor must be the one written by
+// the previous call on the same frame, with the same observer. Writes
+// performed by foreign code through the generated wrappers are not seen.
+namespace mlir::rlc
+{
+	static constexpr llvm::StringLiteral observationDirtyMember =
+			"_observation_dirty";
+	static constexpr llvm::StringLiteral updateObservationFunction =
+			"update_observation_tensor";
+	static constexpr llvm::StringLiteral alwaysDirtyAttr = "rlc.always_dirty";
+
+	static std::optional<size_t> observationDirtyIndex(mlir::rlc::ClassType type)
+	{
+		for (auto field : llvm::enumerate(type.getMembers()))
+			if (field.value().getName() == observationDirtyMember)
+				return field.index();
+		return std::nullopt;
+	}
+
+	static int64_t dirtyBitOf(size_t index) { return int64_t(1) << (index % 63); }
+
+	// the update_observation_tensor functions declared by
+	// DeclareIncrementalObservationPass, associated to the frame they write.
+	using UpdateObservationFunctions = llvm::SmallVector<
+			std::pair<mlir::rlc::ClassType, mlir::rlc::FunctionOp>,
+			2>;
+	static UpdateObservationFunctions updateObservationFunctions(
+			mlir::ModuleOp module)
+	{
+		UpdateObservationFunctions toReturn;
+		for (auto fun : module.getOps<mlir::rlc::FunctionOp>())
+		{
+			if (not isSynthetic(fun) or
+					fun.getUnmangledName() != updateObservationFunction or
+					fun.getArgumentTypes().size() != 3)
+				continue;
+			auto type = fun.getArgumentTypes()[0].dyn_cast<mlir::rlc::ClassType>();
+			if (type and observationDirtyIndex(type))
+				toReturn.emplace_back(type, fun);
+		}
+		return toReturn;
+	}
+
+#define GEN_PASS_DEF_DECLAREINCREMENTALOBSERVATIONPASS
+#include "rlc/dialect/Passes.inc"
+
+	struct DeclareIncrementalObservationPass
+			: impl::DeclareIncrementalObservationPassBase<
+						DeclareIncrementalObservationPass>
+	{
+		void runOnOperation() override
+		{
+			mlir::IRRewriter rewriter(&getContext());
+			auto* ctx = &getContext();
+			llvm::SmallVector<mlir::rlc::ActionFunction, 4> actions(
+					getOperation().getOps<mlir::rlc::ActionFunction>());
+			if (actions.empty())
+				return;
+
+			// the tensor is a Vector<Float>, declared by the standard library
+			if (not hasVectorDeclaration())
+			{
+				auto _ = mlir::rlc::logError(
+						actions.front(),
+						"--incremental-observation requires action to be imported");
+				signalPassFailure();
+				return;
+			}
+
+			for (auto action : actions)
+			{
+				// actions without a declared return type have no name the
+				// declaration of update_observation_tensor can refer to
+				auto frameType = action.getFunctionType().getResult(0);
+				if (auto casted = frameType.dyn_cast<mlir::rlc::ClassType>();
+						casted and casted.getName().empty())
+					continue;
+
+				// frm _observation_dirty = -1
+				rewriter.setInsertionPointToStart(&action.getBody().front());
+				auto decl = rewriter.create<mlir::rlc::DeclarationStatement>(
+						action.getLoc(),
+						mlir::rlc::FrameType::get(mlir::rlc::UnknownType::get(ctx)),
+						observationDirtyMember);
+				markSynthetic(decl);
+				rewriter.createBlock(&decl.getBody());
+				auto allDirty =
+						rewriter.create<mlir::rlc::Constant>(action.getLoc(), int64_t(-1));
+				rewriter.create<mlir::rlc::Yield>(
+						action.getLoc(), mlir::ValueRange({ allDirty }));
+
+				// fun update_observation_tensor(Frame frame, Int observer_id,
+				// Vector<Float> output)
+				rewriter.setInsertionPointAfter(action);
+				auto tensorType = mlir::rlc::ScalarUseType::get(
+						ctx, "Vector", 0, { mlir::rlc::FloatType::get(ctx) });
+				auto ftype = mlir::FunctionType::get(
+						ctx,
+						{ frameType, mlir::rlc::IntegerType::getInt64(ctx), tensorType },
+						{});
+				auto fun = rewriter.create<mlir::rlc::FunctionOp>(
+						action.getLoc(),
+						updateObservationFunction,
+						ftype,
+						mlir::rlc::FunctionInfoAttr::get(
+								ctx, { "frame", "observer_id", "output" }),
+						false);
+				markSynthetic(fun);
+			}
+		}
+
+		private:
+		bool hasVectorDeclaration()
+		{
+			for (auto decl : getOperation().getOps<mlir::rlc::ClassDeclaration>())
+				if (decl.getName() == "Vector")
+					return true;
+			return false;
+		}
+	};
+
+#define GEN_PASS_DEF_EMITINCREMENTALOBSERVATIONPASS
+#include "rlc/dialect/Passes.inc"
+
+	struct EmitIncrementalObservationPass
+			: impl::EmitIncrementalObservationPassBase<
+						EmitIncrementalObservationPass>
+	{
+		void runOnOperation() override
+		{
+			auto updateFunctions = updateObservationFunctions(getOperation());
+			if (updateFunctions.empty())
+				return;
+
+			mlir::rlc::ModuleBuilder builder(getOperation());
+			for (auto [type, fun] : updateFunctions)
+			{
+				if (not fun.isDeclaration())
+					continue;
+				if (emitUpdateFunction(builder, type, fun).failed())
+				{
+					signalPassFailure();
+					return;
+				}
+			}
+		}
+
+		private:
+		// fun update_observation_tensor(Frame frame, Int observer_id,
+		//                               Vector<Float> output):
+		//   _update_observation_tensor(
+		//     frame, frame._observation_dirty | always_dirty, observer_id, output)
+		//   frame._observation_dirty = 0
+		// always_dirty is a constant tagged so that TrackObservationDirtyPass can
+		// add to it the bits of the fields it can't track.
+		mlir::LogicalResult emitUpdateFunction(
+				mlir::rlc::ModuleBuilder& builder,
+				mlir::rlc::ClassType type,
+				mlir::rlc::FunctionOp fun)
+		{
+			auto& rewriter = builder.getRewriter();
+			auto loc = fun.getLoc();
+			auto dirtyIndex = *observationDirtyIndex(type);
+			auto* block = rewriter.createBlock(
+					&fun.getBody(),
+					fun.getBody().begin(),
+					fun.getFunctionType().getInputs(),
+					{ loc, loc, loc });
+			rewriter.setInsertionPointToStart(block);
+			auto frame = block->getArgument(0);
+
+			auto dirty =
+					rewriter.create<mlir::rlc::MemberAccess>(loc, frame, dirtyIndex);
+			auto alwaysDirty = rewriter.create<mlir::rlc::Constant>(loc, int64_t(0));
+			alwaysDirty->setAttr(alwaysDirtyAttr, rewriter.getUnitAttr());
+			auto toUpdate =
+					rewriter.create<mlir::rlc::BitOrOp>(loc, dirty, alwaysDirty);
+			auto* call = builder.emitCall(
+					fun,
+					false,
+					"_update_observation_tensor",
+					mlir::ValueRange(
+							{ frame, toUpdate, block->getArgument(1), block->getArgument(2) }),
+					false);
+			if (call == nullptr)
+				return mlir::rlc::logError(
+						fun,
+						"--incremental-observation requires action to be imported to "
+						"write the observation tensor of " +
+								prettyType(type));
+
+			auto cleared =
+					rewriter.create<mlir::rlc::MemberAccess>(loc, frame, dirtyIndex);
+			auto zero = rewriter.create<mlir::rlc::Constant>(loc, int64_t(0));
+			rewriter.create<mlir::rlc::AssignOp>(loc, cleared, zero);
+			rewriter.create<mlir::rlc::Yield>(loc);
+			return mlir::success();
+		}
+	};
+
+#define GEN_PASS_DEF_TRACKOBSERVATIONDIRTYPASS
+#include "rlc/dialect/Passes.inc"
+
+	struct TrackObservationDirtyPass
+			: impl::TrackObservationDirtyPassBase<TrackObservationDirtyPass>
+	{
+		void runOnOperation() override
+		{
+			auto updateFunctions = updateObservationFunctions(getOperation());
+			if (updateFunctions.empty())
+				return;
+
+			collectStoredArguments();
+			mlir::IRRewriter rewriter(&getContext());
+			for (auto [type, fun] : updateFunctions)
+				if (not fun.isDeclaration())
+					trackFields(rewriter, type, fun);
+		}
+
+		private:
+		// collects the arguments of the functions a reference to which is stored
+		// somewhere, either directly, as the actions do with their context
+		// arguments, or by passing them to a argument that is.
+		void collectStoredArguments()
+		{
+			llvm::SmallVector<mlir::rlc::CallOp, 8> calls;
+			getOperation().walk([&](mlir::Operation* op) {
+				if (auto makeRef = mlir::dyn_cast<mlir::rlc::MakeRefOp>(op))
+					markStored(makeRef.getRef());
+				else if (auto call = mlir::dyn_cast<mlir::rlc::CallOp>(op))
+					calls.push_back(call);
+			});
+
+			bool changed = true;
+			while (changed)
+			{
+				changed = false;
+				for (auto call : calls)
+					for (auto operand : storedOperands(call))
+						changed = markStored(operand) or changed;
+			}
+		}
+
+		// returns true if the value is a argument that was not known to be stored
+		bool markStored(mlir::Value value)
+		{
+			auto arg = value.dyn_cast<mlir::BlockArgument>();
+			if (not arg)
+				return false;
+			auto fun = mlir::dyn_cast<mlir::rlc::FunctionOp>(
+					arg.getOwner()->getParentOp());
+			if (not fun)
+				return false;
+			return storedArguments.insert({ fun.getOperation(), arg.getArgNumber() })
+					.second;
+		}
+
+		llvm::SmallVector<mlir::Value, 2> storedOperands(mlir::rlc::CallOp call)
+		{
+			llvm::SmallVector<mlir::Value, 2> toReturn;
+			auto callee = call.getCallee().getDefiningOp<mlir::rlc::FunctionOp>();
+			if (not callee)
+				return toReturn;
+			for (auto arg : llvm::enumerate(call.getArgs()))
+				if (storedArguments.contains({ callee.getOperation(), arg.index() }))
+					toReturn.push_back(arg.value());
+			return toReturn;
+		}
+
+		// the bits of the fields of frames of the given type a reference to which
+		// is stored somewhere, or -1 if the frame itself is.
+		int64_t collectAlwaysDirtyFields(mlir::rlc::ClassType type)
+		{
+			int64_t mask = 0;
+			auto addRoot = [&](mlir::Value value) {
+				if (value.getType() == type)
+				{
+					mask = -1;
+					return;
+				}
+				if (auto access = rootFieldAccess(value, type))
+					mask |= dirtyBitOf(access.getMemberIndex());
+			};
+
+			getOperation().walk([&](mlir::Operation* op) {
+				if (auto makeRef = mlir::dyn_cast<mlir::rlc::MakeRefOp>(op))
+					addRoot(makeRef.getRef());
+				else if (auto call = mlir::dyn_cast<mlir::rlc::CallOp>(op))
+					for (auto operand : storedOperands(call))
+						addRoot(operand);
+				else if (auto decl = mlir::dyn_cast<mlir::rlc::DeclarationStatement>(op);
+								 decl and decl.isReference() and not decl.getBody().empty())
+				{
+					auto yield =
+							mlir::dyn_cast<mlir::rlc::Yield>(decl.getBody().front().back());
+					if (yield)
+						for (auto value : yield.getArguments())
+							addRoot(value);
+				}
+			});
+			return mask;
+		}
+
+		// frame.field[x].subfield becomes frame.field
+		static mlir::rlc::MemberAccess rootFieldAccess(
+				mlir::Value value, mlir::rlc::ClassType type)
+		{
+			while (auto* op = value.getDefiningOp())
+			{
+				if (auto access = mlir::dyn_cast<mlir::rlc::MemberAccess>(op))
+				{
+					if (access.getValue().getType() == type)
+						return access;
+					value = access.getValue();
+				}
+				else if (auto access = mlir::dyn_cast<mlir::rlc::ArrayAccess>(op))
+					value = access.getValue();
+				else
+					return nullptr;
+			}
+			return nullptr;
+		}
+
+		void trackFields(
+				mlir::IRRewriter& rewriter,
+				mlir::rlc::ClassType type,
+				mlir::rlc::FunctionOp updateFunction)
+		{
+			auto dirtyIndex = *observationDirtyIndex(type);
+
+			llvm::SmallVector<std::pair<mlir::rlc::MemberAccess, int64_t>, 8>
+					fieldWrites;
+			llvm::SmallVector<std::pair<mlir::Operation*, mlir::Value>, 4>
+					wholeWrites;
+			getOperation().walk([&](mlir::Operation* op) {
+				if (updateFunction->isAncestor(op))
+					return;
+				if (auto access = mlir::dyn_cast<mlir::rlc::MemberAccess>(op);
+						access and access.getValue().getType() == type)
+				{
+					auto index = access.getMemberIndex();
+					// the resume index is not part of the tensor
+					if (index == 0 or readOnlyUses.isReadOnly(access.getResult()))
+						return;
+					if (index != int64_t(dirtyIndex))
+					{
+						fieldWrites.emplace_back(access, dirtyBitOf(index));
+						return;
+					}
+
+					// whoever writes the dirty bits, such as the implicit assignment
+					// of the frame or undo, is copying the frame as a whole, they are
+					// all set after the write.
+					for (auto& use : access.getResult().getUses())
+						if (not use.getOwner()->hasTrait<mlir::OpTrait::IsTerminator>() and
+								not readOnlyUses.isReadOnly(use))
+							wholeWrites.emplace_back(use.getOwner(), access.getValue());
+					return;
+				}
+
+				for (auto& use : op->getOpOperands())
+					if (use.get().getType() == type and writesWholeFrame(use))
+						wholeWrites.emplace_back(op, use.get());
+			});
+
+			for (auto [access, bit] : fieldWrites)
+			{
+				rewriter.setInsertionPointAfter(access);
+				markDirty(rewriter, access.getLoc(), access.getValue(), dirtyIndex, bit);
+			}
+			for (auto [op, frame] : wholeWrites)
+			{
+				rewriter.setInsertionPointAfter(op);
+				markDirty(rewriter, op->getLoc(), frame, dirtyIndex, -1);
+			}
+
+			auto mask = collectAlwaysDirtyFields(type);
+			if (mask != 0)
+				updateFunction.walk([&](mlir::rlc::Constant constant) {
+					if (not constant->hasAttr(alwaysDirtyAttr))
+						return;
+					rewriter.setInsertionPoint(constant);
+					auto replacement =
+							rewriter.create<mlir::rlc::Constant>(constant.getLoc(), mask);
+					rewriter.replaceOp(constant, replacement.getResult());
+				});
+		}
+
+		// uses of the frame that may write it without going through one of its
+		// member accesses. Calls to functions with a body are not, since the
+		// member accesses of the callee are tracked too.
+		bool writesWholeFrame(mlir::OpOperand& use)
+		{
+			auto* owner = use.getOwner();
+			if (owner->hasTrait<mlir::OpTrait::IsTerminator>() or
+					readOnlyUses.isReadOnly(use))
+				return false;
+			if (auto call = mlir::dyn_cast<mlir::rlc::CallOp>(owner))
+			{
+				auto callee = call.getCallee().getDefiningOp<mlir::rlc::FunctionOp>();
+				return use.getOperandNumber() == 0 or not callee or
+							 callee.isDeclaration();
+			}
+			return true;
+		}
+
+		// frame._observation_dirty = frame._observation_dirty | bit
+		void markDirty(
+				mlir::IRRewriter& rewriter,
+				mlir::Location loc,
+				mlir::Value frame,
+				size_t dirtyIndex,
+				int64_t bit)
+		{
+			auto dirty =
+					rewriter.create<mlir::rlc::MemberAccess>(loc, frame, dirtyIndex);
+			auto constant = rewriter.create<mlir::rlc::Constant>(loc, bit);
+			auto marked = rewriter.create<mlir::rlc::BitOrOp>(loc, dirty, constant);
+			rewriter.create<mlir::rlc::BuiltinAssignOp>(loc, dirty, marked);
+		}
+
+		ReadOnlyUses readOnlyUses;
+		llvm::DenseSet<std::pair<mlir::Operation*, unsigned>> storedArguments;
+	};
+}	 // namespace mlir::rlc
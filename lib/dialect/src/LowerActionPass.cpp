@@ -422,6 +422,7 @@ namespace mlir::rlc
 				mlir::rlc::FunctionInfoAttr::get(
 						action.getContext(), firstStatement.getDeclaredNames()),
 				true);
+		markActionStatementWrapper(subF);
 		action.getActions()[subActionIndex].replaceAllUsesWith(subF);
 
 		// steals the precondition of all possible actions to take from here and
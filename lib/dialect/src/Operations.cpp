@@ -2677,6 +2677,20 @@ mlir::LogicalResult mlir::rlc::FreeOp::typeCheck(
 	return mlir::success();
 }
 
+mlir::LogicalResult mlir::rlc::ReallocOp::typeCheck(
+		mlir::rlc::ModuleBuilder &builder)
+{
+	if (not getArgument().getType().isa<mlir::rlc::OwningPtrType>())
+		return logError(
+				*this,
+				"First argument of __builtin_realloc_do_not_use must be a OwningPtr");
+	if (getSize().getType() != mlir::rlc::IntegerType::getInt64(getContext()))
+		return logError(
+				*this, "Second argument of __builtin_realloc_do_not_use must be a Int");
+	getResult().setType(getArgument().getType());
+	return mlir::success();
+}
+
 mlir::LogicalResult mlir::rlc::BuiltinMangledNameOp::typeCheck(
 		mlir::rlc::ModuleBuilder &builder)
 {
@@ -2689,6 +2703,83 @@ mlir::LogicalResult mlir::rlc::BuiltinAsPtr::typeCheck(
 	return mlir::success();
 }
 
+mlir::LogicalResult mlir::rlc::BuiltinMatchGroupOp::typeCheck(
+		mlir::rlc::ModuleBuilder &builder)
+{
+	auto byteType = mlir::rlc::IntegerType::getInt8(getContext());
+	auto control = getControl().getType().dyn_cast<mlir::rlc::OwningPtrType>();
+	if (not control or control.getUnderlying() != byteType)
+		return logError(
+				*this,
+				"First argument of __builtin_match_group_do_not_use must be a "
+				"OwningPtr<Byte>");
+	if (getIndex().getType() !=
+			mlir::rlc::IntegerType::getInt64(getContext()))
+		return logError(
+				*this,
+				"Second argument of __builtin_match_group_do_not_use must be a Int");
+	if (getTag().getType() != byteType)
+		return logError(
+				*this,
+				"Third argument of __builtin_match_group_do_not_use must be a Byte");
+	return mlir::success();
+}
+
+mlir::LogicalResult mlir::rlc::BuiltinHashBytesOp::typeCheck(
+		mlir::rlc::ModuleBuilder &builder)
+{
+	if (not getCount())
+		return mlir::success();
+	if (not getValue().getType().isa<mlir::rlc::OwningPtrType>())
+		return logError(
+				*this,
+				"First argument of __builtin_hash_bytes_do_not_use must be a "
+				"OwningPtr when the number of elements is provided");
+	if (getCount().getType() != mlir::rlc::IntegerType::getInt64(getContext()))
+		return logError(
+				*this,
+				"Second argument of __builtin_hash_bytes_do_not_use must be a Int");
+	return mlir::success();
+}
+
+mlir::LogicalResult mlir::rlc::BuiltinIsPlainDataOp::typeCheck(
+		mlir::rlc::ModuleBuilder &builder)
+{
+	return mlir::success();
+}
+
+mlir::LogicalResult mlir::rlc::BuiltinSizeOfOp::typeCheck(
+		mlir::rlc::ModuleBuilder &builder)
+{
+	return mlir::success();
+}
+
+mlir::LogicalResult mlir::rlc::BuiltinCopyBytesOp::typeCheck(
+		mlir::rlc::ModuleBuilder &builder)
+{
+	if (getSize().getType() != mlir::rlc::IntegerType::getInt64(getContext()))
+		return logError(
+				*this,
+				"Third argument of __builtin_copy_bytes_do_not_use must be a Int");
+	return mlir::success();
+}
+
+mlir::LogicalResult mlir::rlc::BuiltinStoreFloat32Op::typeCheck(
+		mlir::rlc::ModuleBuilder &builder)
+{
+	if (getDestination().getType() !=
+			mlir::rlc::IntegerType::getInt8(getContext()))
+		return logError(
+				*this,
+				"First argument of __builtin_store_float32_do_not_use must be a Byte");
+	if (not getValue().getType().isa<mlir::rlc::FloatType>())
+		return logError(
+				*this,
+				"Second argument of __builtin_store_float32_do_not_use must be a "
+				"Float");
+	return mlir::success();
+}
+
 mlir::LogicalResult mlir::rlc::BuiltinAssignOp::typeCheck(
 		mlir::rlc::ModuleBuilder &builder)
 {
@@ -3453,3 +3544,22 @@ mlir::rlc::ClassDeclaration::getMemberField(size_t i)
 {
 	return getMemberFields()[i];
 }
+
+mlir::rlc::FunctionOp mlir::rlc::getCanCallee(mlir::rlc::CanOp op)
+{
+	return op.getCallee().getDefiningOp<mlir::rlc::FunctionOp>();
+}
+
+mlir::rlc::FunctionOp mlir::rlc::findStatementWrapper(
+		mlir::rlc::FunctionOp applyFunction)
+{
+	if (applyFunction.getPrecondition().empty())
+		return nullptr;
+	for (auto canOp : applyFunction.getPrecondition().getOps<mlir::rlc::CanOp>())
+	{
+		auto callee = getCanCallee(canOp);
+		if (callee and not callee.getPrecondition().empty())
+			return callee;
+	}
+	return nullptr;
+}
@@ -0,0 +1,396 @@
+/*
+Copyright 2024 Massimo Fioravanti
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	 http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/StringSwitch.h"
+#include "llvm/ADT/TypeSwitch.h"
+#include "mlir/IR/BuiltinDialect.h"
+#include "mlir/IR/PatternMatch.h"
+#include "rlc/dialect/ConstraintsAnalysis.hpp"
+#include "rlc/dialect/Operations.hpp"
+#include "rlc/dialect/Passes.hpp"
+
+namespace mlir::rlc
+{
+	using IntegerRange = ConstraintsLattice::IntegerRange;
+	// maps the index of a argument of a precondition to the values that
+	// argument must have for the precondition to be true. Missing arguments
+	// are unconstrained.
+	using ArgumentRanges = llvm::DenseMap<unsigned, IntegerRange>;
+
+	// returns the index of the block argument if value is a BInt argument of
+	// the precondition, or arg.value when lookThroughValue is set
+	static std::optional<unsigned> getBoundedArgument(
+			mlir::Value value, bool lookThroughValue)
+	{
+		if (lookThroughValue)
+		{
+			auto access = value.getDefiningOp<mlir::rlc::MemberAccess>();
+			if (not access or access.getMemberIndex() != 0)
+				return std::nullopt;
+			value = access.getValue();
+		}
+
+		auto arg = value.dyn_cast<mlir::BlockArgument>();
+		if (not arg)
+			return std::nullopt;
+
+		auto type = arg.getType().dyn_cast<mlir::rlc::ClassType>();
+		if (not type or type.getName() != "BInt")
+			return std::nullopt;
+		return arg.getArgNumber();
+	}
+
+	static std::optional<int64_t> getIntegerConstant(mlir::Value value)
+	{
+		auto constant = value.getDefiningOp<mlir::rlc::Constant>();
+		if (not constant)
+			return std::nullopt;
+		auto attr = constant.getValue().dyn_cast<mlir::IntegerAttr>();
+		if (not attr)
+			return std::nullopt;
+		return attr.getInt();
+	}
+
+	enum class Comparison
+	{
+		less,
+		lessEqual,
+		greater,
+		greaterEqual,
+		equal
+	};
+
+	// x.value < 7 is a builtin comparison, while x < 7 is a call to
+	// BInt::less(Int)
+	static std::optional<Comparison> getComparison(mlir::Operation* op)
+	{
+		if (auto call = mlir::dyn_cast<mlir::rlc::CallOp>(op))
+		{
+			auto callee = call.getCallee().getDefiningOp<mlir::rlc::FunctionOp>();
+			if (not callee)
+				return std::nullopt;
+			return llvm::StringSwitch<std::optional<Comparison>>(
+								 callee.getUnmangledName())
+					.Case("less", Comparison::less)
+					.Case("less_equal", Comparison::lessEqual)
+					.Case("greater", Comparison::greater)
+					.Case("greater_equal", Comparison::greaterEqual)
+					.Case("equal", Comparison::equal)
+					.Default(std::nullopt);
+		}
+
+		return llvm::TypeSwitch<mlir::Operation*, std::optional<Comparison>>(op)
+				.Case([](mlir::rlc::LessOp) { return Comparison::less; })
+				.Case([](mlir::rlc::LessEqualOp) { return Comparison::lessEqual; })
+				.Case([](mlir::rlc::GreaterOp) { return Comparison::greater; })
+				.Case(
+						[](mlir::rlc::GreaterEqualOp) { return Comparison::greaterEqual; })
+				.Case([](mlir::rlc::EqualOp) { return Comparison::equal; })
+				.Default([](mlir::Operation*) { return std::nullopt; });
+	}
+
+	// range of the values of x for which `x comparison constant` is true
+	static IntegerRange rangeOfComparison(
+			Comparison comparison, int64_t constant, bool constantOnLhs)
+	{
+		using Lattice = ConstraintsLattice;
+		auto lessThan = [](int64_t c) {
+			if (c == Lattice::MIN)
+				return IntegerRange::getEmpty(Lattice::BITWIDTH);
+			return Lattice::createRange(Lattice::MIN, c - 1);
+		};
+		auto greaterThan = [](int64_t c) {
+			if (c == Lattice::MAX)
+				return IntegerRange::getEmpty(Lattice::BITWIDTH);
+			return Lattice::createRange(c + 1, Lattice::MAX);
+		};
+		auto atMost = [](int64_t c) { return Lattice::createRange(Lattice::MIN, c); };
+		auto atLeast = [](int64_t c) { return Lattice::createRange(c, Lattice::MAX); };
+
+		switch (comparison)
+		{
+			case Comparison::less:
+				return constantOnLhs ? greaterThan(constant) : lessThan(constant);
+			case Comparison::lessEqual:
+				return constantOnLhs ? atLeast(constant) : atMost(constant);
+			case Comparison::greater:
+				return constantOnLhs ? lessThan(constant) : greaterThan(constant);
+			case Comparison::greaterEqual:
+				return constantOnLhs ? atMost(constant) : atLeast(constant);
+			case Comparison::equal:
+				return Lattice::createRange(constant);
+		}
+		llvm_unreachable("unhandled comparison");
+	}
+
+	static ArgumentRanges meet(ArgumentRanges lhs, const ArgumentRanges& rhs)
+	{
+		for (const auto& [index, range] : rhs)
+		{
+			auto iter = lhs.find(index);
+			if (iter == lhs.end())
+				lhs.try_emplace(index, range);
+			else
+				iter->second = ConstraintsLattice::meetRange(iter->second, range);
+		}
+		return lhs;
+	}
+
+	// arguments constrained on only one side of the or are unconstrained
+	static ArgumentRanges join(const ArgumentRanges& lhs, const ArgumentRanges& rhs)
+	{
+		ArgumentRanges toReturn;
+		for (const auto& [index, range] : lhs)
+		{
+			auto iter = rhs.find(index);
+			if (iter != rhs.end())
+				toReturn.try_emplace(
+						index, ConstraintsLattice::joinRange(range, iter->second));
+		}
+		return toReturn;
+	}
+
+	static ArgumentRanges argumentRangesOf(mlir::Value value);
+
+	// the values yielded by a precondition, or by a side of a short circuiting
+	// operator, must all be true
+	static ArgumentRanges argumentRangesOfYielded(mlir::Region& region)
+	{
+		ArgumentRanges toReturn;
+		for (auto value : region.front().getTerminator()->getOperands())
+			toReturn = meet(std::move(toReturn), argumentRangesOf(value));
+		return toReturn;
+	}
+
+	// computes the ranges of the BInt arguments that can make value true. It
+	// only understands and, or and comparisons between arguments and constants,
+	// everything else is considered to be satisfiable by any argument, so the
+	// result is always a over approximation of the valid arguments.
+	static ArgumentRanges argumentRangesOf(mlir::Value value)
+	{
+		auto* op = value.getDefiningOp();
+		if (op == nullptr)
+			return {};
+
+		if (mlir::isa<mlir::rlc::AndOp>(op))
+			return meet(
+					argumentRangesOf(op->getOperand(0)),
+					argumentRangesOf(op->getOperand(1)));
+
+		if (mlir::isa<mlir::rlc::OrOp>(op))
+			return join(
+					argumentRangesOf(op->getOperand(0)),
+					argumentRangesOf(op->getOperand(1)));
+
+		if (auto andOp = mlir::dyn_cast<mlir::rlc::ShortCircuitingAnd>(op))
+			return meet(
+					argumentRangesOfYielded(andOp.getLhs()),
+					argumentRangesOfYielded(andOp.getRhs()));
+
+		if (auto orOp = mlir::dyn_cast<mlir::rlc::ShortCircuitingOr>(op))
+			return join(
+					argumentRangesOfYielded(orOp.getLhs()),
+					argumentRangesOfYielded(orOp.getRhs()));
+
+		auto comparison = getComparison(op);
+		if (not comparison)
+			return {};
+
+		// calls have the callee as first operand
+		bool isCall = mlir::isa<mlir::rlc::CallOp>(op);
+		auto operands = isCall ? mlir::cast<mlir::rlc::CallOp>(op).getArgs()
+													 : op->getOperands();
+		if (operands.size() != 2)
+			return {};
+
+		auto lhsArg = getBoundedArgument(operands[0], not isCall);
+		auto rhsArg = getBoundedArgument(operands[1], not isCall);
+		auto lhsConstant = getIntegerConstant(operands[0]);
+		auto rhsConstant = getIntegerConstant(operands[1]);
+
+		ArgumentRanges toReturn;
+		if (lhsArg and rhsConstant)
+			toReturn.try_emplace(
+					*lhsArg, rangeOfComparison(*comparison, *rhsConstant, false));
+		else if (rhsArg and lhsConstant and not isCall)
+			toReturn.try_emplace(
+					*rhsArg, rangeOfComparison(*comparison, *lhsConstant, true));
+		return toReturn;
+	}
+
+	// returns, for each member of the action class that can be pruned, the
+	// range of values that member can ever assume in a valid action.
+	static ArgumentRanges prunableMembers(
+			mlir::rlc::ClassType actionType, mlir::rlc::FunctionOp wrapper)
+	{
+		auto& precondition = wrapper.getPrecondition();
+		if (not precondition.hasOneBlock())
+			return {};
+		auto& block = precondition.front();
+		if (block.getNumArguments() != actionType.getMembers().size() + 1)
+			return {};
+
+		auto ranges = argumentRangesOfYielded(precondition);
+
+		ArgumentRanges toReturn;
+		for (auto& [index, range] : ranges)
+		{
+			// argument 0 is the frame
+			if (index == 0)
+				continue;
+
+			auto type = block.getArgument(index).getType().cast<ClassType>();
+			auto parameters = type.getExplicitTemplateParameters();
+			if (parameters.size() != 2)
+				continue;
+			auto min = parameters[0].dyn_cast<mlir::rlc::IntegerLiteralType>();
+			auto max = parameters[1].dyn_cast<mlir::rlc::IntegerLiteralType>();
+			if (not min or not max or min.getValue() >= max.getValue())
+				continue;
+
+			auto declared =
+					ConstraintsLattice::createRange(min.getValue(), max.getValue() - 1);
+			auto reachable = ConstraintsLattice::meetRange(declared, range);
+			if (reachable == declared)
+				continue;
+			toReturn.try_emplace(index - 1, reachable);
+		}
+		return toReturn;
+	}
+
+	// emits the condition `obj.member.value in range` for all pruned members
+	static mlir::Value emitIsEnumerable(
+			mlir::IRRewriter& rewriter,
+			mlir::Location loc,
+			mlir::Value obj,
+			const ArgumentRanges& ranges)
+	{
+		mlir::Value result = rewriter.create<mlir::rlc::Constant>(loc, true);
+		for (const auto& [member, range] : ranges)
+		{
+			if (range.isEmptySet())
+				return rewriter.create<mlir::rlc::Constant>(loc, false);
+
+			auto value = rewriter.create<mlir::rlc::MemberAccess>(
+					loc, rewriter.create<mlir::rlc::MemberAccess>(loc, obj, member), 0);
+			auto lower = rewriter.create<mlir::rlc::Constant>(
+					loc, range.getSignedMin().getSExtValue());
+			auto upper = rewriter.create<mlir::rlc::Constant>(
+					loc, range.getSignedMax().getSExtValue());
+			result = rewriter.create<mlir::rlc::AndOp>(
+					loc,
+					result,
+					rewriter.create<mlir::rlc::GreaterEqualOp>(loc, value, lower));
+			result = rewriter.create<mlir::rlc::AndOp>(
+					loc,
+					result,
+					rewriter.create<mlir::rlc::LessEqualOp>(loc, value, upper));
+		}
+		return result;
+	}
+
+	// _enumerate_impl(GameX obj, ...) appends obj to the output once all its
+	// members have been assigned, guard that append so that actions whose
+	// arguments can never satisfy the precondition are never added.
+	static void pruneEnumeration(
+			mlir::rlc::FunctionOp enumerateImpl,
+			mlir::rlc::ClassType actionType,
+			const ArgumentRanges& ranges,
+			mlir::IRRewriter& rewriter)
+	{
+		llvm::SmallVector<mlir::rlc::CallOp, 2> appends;
+		enumerateImpl.walk([&](mlir::rlc::CallOp call) {
+			auto callee = call.getCallee().getDefiningOp<mlir::rlc::FunctionOp>();
+			if (not callee or callee.getUnmangledName() != "append")
+				return;
+			if (call.getArgs().size() != 2 or
+					call.getArgs()[1].getType() != actionType)
+				return;
+			appends.push_back(call);
+		});
+
+		for (auto call : appends)
+		{
+			rewriter.setInsertionPoint(call);
+			auto ifStatement = rewriter.create<mlir::rlc::IfStatement>(call.getLoc());
+			rewriter.createBlock(&ifStatement.getCondition());
+			auto condition =
+					emitIsEnumerable(rewriter, call.getLoc(), call.getArgs()[1], ranges);
+			rewriter.create<mlir::rlc::Yield>(
+					call.getLoc(), mlir::ValueRange({ condition }));
+
+			auto* trueBranch = rewriter.createBlock(&ifStatement.getTrueBranch());
+			rewriter.create<mlir::rlc::Yield>(call.getLoc());
+			call->moveBefore(&trueBranch->front());
+
+			rewriter.createBlock(&ifStatement.getElseBranch());
+			rewriter.create<mlir::rlc::Yield>(call.getLoc());
+		}
+	}
+
+#define GEN_PASS_DEF_PRUNEACTIONENUMERATIONPASS
+#include "rlc/dialect/Passes.inc"
+
+	struct PruneActionEnumerationPass
+			: impl::PruneActionEnumerationPassBase<PruneActionEnumerationPass>
+	{
+		using impl::PruneActionEnumerationPassBase<
+				PruneActionEnumerationPass>::PruneActionEnumerationPassBase;
+
+		void runOnOperation() override
+		{
+			llvm::DenseMap<mlir::Type, ArgumentRanges> prunable;
+			for (auto fun : getOperation().getOps<mlir::rlc::FunctionOp>())
+			{
+				if (not isSynthetic(fun) or fun.getUnmangledName() != "apply")
+					continue;
+				if (fun.getArgumentTypes().size() != 2 or
+						fun.getPrecondition().empty())
+					continue;
+				auto actionType =
+						fun.getArgumentTypes()[0].dyn_cast<mlir::rlc::ClassType>();
+				if (not actionType)
+					continue;
+
+				auto wrapper = findStatementWrapper(fun);
+				if (not wrapper)
+					continue;
+
+				auto ranges = prunableMembers(actionType, wrapper);
+				if (not ranges.empty())
+					prunable[actionType] = std::move(ranges);
+			}
+
+			mlir::IRRewriter rewriter(&getContext());
+			for (auto fun : getOperation().getOps<mlir::rlc::FunctionOp>())
+			{
+				if (fun.getUnmangledName() != "_enumerate_impl" or
+						fun.isDeclaration() or fun.getArgumentTypes().empty())
+					continue;
+
+				auto iter = prunable.find(fun.getArgumentTypes()[0]);
+				if (iter == prunable.end())
+					continue;
+
+				pruneEnumeration(
+						fun,
+						iter->first.cast<mlir::rlc::ClassType>(),
+						iter->second,
+						rewriter);
+			}
+		}
+	};
+}	 // namespace mlir::rlc
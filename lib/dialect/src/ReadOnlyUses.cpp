@@ -0,0 +1,119 @@
+/*
+Copyright 2024 Massimo Fioravanti
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	 http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "rlc/dialect/ReadOnlyUses.hpp"
+
+namespace mlir::rlc
+{
+	bool ReadOnlyUses::isReadOnly(mlir::Value value)
+	{
+		for (auto& use : value.getUses())
+			if (not isReadOnly(use))
+				return false;
+		return true;
+	}
+
+	bool ReadOnlyUses::isReadOnly(mlir::OpOperand& use)
+	{
+		auto* owner = use.getOwner();
+		if (mlir::isa<
+						mlir::rlc::AddOp,
+						mlir::rlc::SubOp,
+						mlir::rlc::MultOp,
+						mlir::rlc::DivOp,
+						mlir::rlc::ReminderOp,
+						mlir::rlc::MinusOp,
+						mlir::rlc::NotOp,
+						mlir::rlc::AndOp,
+						mlir::rlc::OrOp,
+						mlir::rlc::EqualOp,
+						mlir::rlc::NotEqualOp,
+						mlir::rlc::LessOp,
+						mlir::rlc::LessEqualOp,
+						mlir::rlc::GreaterOp,
+						mlir::rlc::GreaterEqualOp,
+						mlir::rlc::BitAndOp,
+						mlir::rlc::BitOrOp,
+						mlir::rlc::BitXorOp,
+						mlir::rlc::BitNotOp,
+						mlir::rlc::LeftShiftOp,
+						mlir::rlc::RightShiftOp,
+						mlir::rlc::CastOp,
+						mlir::rlc::IsOp,
+						mlir::rlc::CanOp,
+						mlir::rlc::BuiltinMatchGroupOp,
+						mlir::rlc::BuiltinHashBytesOp,
+						mlir::rlc::BuiltinIsPlainDataOp,
+						mlir::rlc::BuiltinSizeOfOp>(owner))
+			return true;
+
+		if (mlir::isa<
+						mlir::rlc::BuiltinCopyBytesOp,
+						mlir::rlc::BuiltinStoreFloat32Op>(owner))
+			return use.getOperandNumber() != 0;
+
+		if (mlir::isa<mlir::rlc::MemberAccess, mlir::rlc::ArrayAccess>(owner))
+			return use.getOperandNumber() != 0 or isReadOnly(owner->getResult(0));
+
+		if (mlir::isa<mlir::rlc::BuiltinAssignOp>(owner))
+			return use.getOperandNumber() == 1;
+
+		if (mlir::isa<mlir::rlc::Yield>(owner))
+		{
+			auto* parent = owner->getParentOp();
+			if (auto decl = mlir::dyn_cast<mlir::rlc::DeclarationStatement>(parent))
+				return not decl.isReference();
+			if (auto ret = mlir::dyn_cast<mlir::rlc::ReturnStatement>(parent))
+				return not ret.getResult().isa<mlir::rlc::ReferenceType>();
+			return true;
+		}
+
+		if (auto call = mlir::dyn_cast<mlir::rlc::CallOp>(owner))
+		{
+			auto callee = call.getCallee().getDefiningOp<mlir::rlc::FunctionOp>();
+			if (not callee or use.getOperandNumber() == 0)
+				return false;
+			return isReadOnlyArgument(callee, use.getOperandNumber() - 1);
+		}
+
+		return false;
+	}
+
+	// recursive functions are assumed to only read their arguments until
+	// proven otherwise. Only the answers that do not depend on such an
+	// assumption are cached.
+	bool ReadOnlyUses::isReadOnlyArgument(
+			mlir::rlc::FunctionOp fun, unsigned index)
+	{
+		auto key = std::make_pair(fun.getOperation(), index);
+		if (auto iter = cache.find(key); iter != cache.end())
+			return iter->second;
+		if (fun.isDeclaration())
+			return cache[key] = false;
+		if (inProgress.contains(key))
+			return true;
+
+		inProgress.insert(key);
+		bool readOnly = true;
+		for (auto* region : { &fun.getBody(), &fun.getPrecondition() })
+			if (not region->empty())
+				readOnly = readOnly and isReadOnly(region->front().getArgument(index));
+		inProgress.erase(key);
+
+		if (not readOnly or inProgress.empty())
+			cache[key] = readOnly;
+		return readOnly;
+	}
+}	 // namespace mlir::rlc
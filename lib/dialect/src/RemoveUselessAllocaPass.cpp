@@ -23,7 +23,7 @@ namespace mlir::rlc
 #define GEN_PASS_DEF_REMOVEUSELESSALLOCAPASS
 #include "rlc/dialect/Passes.inc"
 
-	static void removeUselessAlloca(mlir::ModuleOp op)
+	static void removeUselessAlloca(mlir::LLVM::LLVMFuncOp op)
 	{
 		llvm::DenseSet<mlir::LLVM::AllocaOp> allocas;
 		op.walk([&](mlir::LLVM::AllocaOp alloca) { allocas.insert(alloca); });
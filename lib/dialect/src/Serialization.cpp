@@ -738,6 +738,79 @@ void mlir::rlc::FreeOp::serialize(
 	OS << ")";
 }
 
+void mlir::rlc::BuiltinMatchGroupOp::serialize(
+		llvm::raw_ostream& OS, mlir::rlc::SerializationContext& ctx)
+{
+	OS << "__builtin_match_group_do_not_use(";
+	serializeExpression(getControl(), OS, ctx);
+	OS << ", ";
+	serializeExpression(getIndex(), OS, ctx);
+	OS << ", ";
+	serializeExpression(getTag(), OS, ctx);
+	OS << ")";
+}
+
+void mlir::rlc::ReallocOp::serialize(
+		llvm::raw_ostream& OS, mlir::rlc::SerializationContext& ctx)
+{
+	OS << "__builtin_realloc_do_not_use(";
+	serializeExpression(getArgument(), OS, ctx);
+	OS << ", ";
+	serializeExpression(getSize(), OS, ctx);
+	OS << ")";
+}
+
+void mlir::rlc::BuiltinStoreFloat32Op::serialize(
+		llvm::raw_ostream& OS, mlir::rlc::SerializationContext& ctx)
+{
+	OS << "__builtin_store_float32_do_not_use(";
+	serializeExpression(getDestination(), OS, ctx);
+	OS << ", ";
+	serializeExpression(getValue(), OS, ctx);
+	OS << ")";
+}
+
+void mlir::rlc::BuiltinHashBytesOp::serialize(
+		llvm::raw_ostream& OS, mlir::rlc::SerializationContext& ctx)
+{
+	OS << "__builtin_hash_bytes_do_not_use(";
+	serializeExpression(getValue(), OS, ctx);
+	if (getCount())
+	{
+		OS << ", ";
+		serializeExpression(getCount(), OS, ctx);
+	}
+	OS << ")";
+}
+
+void mlir::rlc::BuiltinIsPlainDataOp::serialize(
+		llvm::raw_ostream& OS, mlir::rlc::SerializationContext& ctx)
+{
+	OS << "__builtin_is_plain_data_do_not_use(";
+	serializeExpression(getValue(), OS, ctx);
+	OS << ")";
+}
+
+void mlir::rlc::BuiltinSizeOfOp::serialize(
+		llvm::raw_ostream& OS, mlir::rlc::SerializationContext& ctx)
+{
+	OS << "__builtin_size_of_do_not_use(";
+	serializeExpression(getValue(), OS, ctx);
+	OS << ")";
+}
+
+void mlir::rlc::BuiltinCopyBytesOp::serialize(
+		llvm::raw_ostream& OS, mlir::rlc::SerializationContext& ctx)
+{
+	OS << "__builtin_copy_bytes_do_not_use(";
+	serializeExpression(getDestination(), OS, ctx);
+	OS << ", ";
+	serializeExpression(getSource(), OS, ctx);
+	OS << ", ";
+	serializeExpression(getSize(), OS, ctx);
+	OS << ")";
+}
+
 void mlir::rlc::MallocOp::serialize(
 		llvm::raw_ostream& OS, mlir::rlc::SerializationContext& ctx)
 {
@@ -0,0 +1,292 @@
+/*
+Copyright 2024 Massimo Fioravanti
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+	 http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#include "llvm/ADT/DenseSet.h"
+#include "mlir/IR/BuiltinDialect.h"
+#include "mlir/IR/PatternMatch.h"
+#include "rlc/dialect/Operations.hpp"
+#include "rlc/dialect/Passes.hpp"
+#include "rlc/dialect/ReadOnlyUses.hpp"
+
+// Undo logs let a search apply a action to a game and then revert it in place,
+// without cloning the whole game before every move:
+//
+// let log : GameUndoLog
+// record_undo(game, log)
+// apply(action, game)
+// undo(game, log)
+//
+// They are built in three steps:
+//
+// - before type checking each action function gets a class <Frame>UndoLog
+// holding a copy of the frame, and the declarations of
+// record_undo(Frame, <Frame>UndoLog) and undo(Frame, <Frame>UndoLog).
+// - before templates are instantiated record_undo is defined as copying every
+// field of the frame into the log, and undo as copying them back.
+// - once actions have been lowered to plain functions, the fields that no
+// action statement can write are dropped from both functions, so that
+// recording and undoing a move costs as much as the fields the move may
+// have changed, and the log itself can be reused across moves.
+//
+// Writes performed to the frame outside of actions, such as assigning a
+// field from the outside, are not undone unless some action writes that
+// field too.
+namespace mlir::rlc
+{
+	static constexpr llvm::StringLiteral undoLogSuffix = "UndoLog";
+	static constexpr llvm::StringLiteral undoLogSavedMember = "saved";
+	static constexpr llvm::StringLiteral recordUndoFunction = "record_undo";
+	static constexpr llvm::StringLiteral undoFunction = "undo";
+
+	// the record_undo and undo functions declared by DeclareUndoLogPass
+	static llvm::SmallVector<mlir::rlc::FunctionOp, 4> undoLogFunctions(
+			mlir::ModuleOp module)
+	{
+		llvm::SmallVector<mlir::rlc::FunctionOp, 4> toReturn;
+		for (auto fun : module.getOps<mlir::rlc::FunctionOp>())
+		{
+			if (not isSynthetic(fun) or fun.getArgumentTypes().size() != 2 or
+					(fun.getUnmangledName() != recordUndoFunction and
+					 fun.getUnmangledName() != undoFunction))
+				continue;
+			if (fun.getArgumentTypes()[0].isa<mlir::rlc::ClassType>())
+				toReturn.push_back(fun);
+		}
+		return toReturn;
+	}
+
+#define GEN_PASS_DEF_DECLAREUNDOLOGPASS
+#include "rlc/dialect/Passes.inc"
+
+	struct DeclareUndoLogPass: impl::DeclareUndoLogPassBase<DeclareUndoLogPass>
+	{
+		void runOnOperation() override
+		{
+			mlir::IRRewriter rewriter(&getContext());
+			auto* ctx = &getContext();
+			llvm::SmallVector<mlir::rlc::ActionFunction, 4> actions(
+					getOperation().getOps<mlir::rlc::ActionFunction>());
+			for (auto action : actions)
+			{
+				// actions without a declared return type have no name the log can
+				// refer to
+				auto frameType = action.getFunctionType()
+														 .getResult(0)
+														 .dyn_cast<mlir::rlc::ClassType>();
+				if (not frameType or frameType.getName().empty())
+					continue;
+
+				// cls <Frame>UndoLog:
+				//   <Frame> saved
+				auto logName = (frameType.getName() + undoLogSuffix).str();
+				rewriter.setInsertionPointAfter(action);
+				auto log = rewriter.create<mlir::rlc::ClassDeclaration>(
+						action.getLoc(), logName, mlir::ArrayRef<mlir::Type>({}));
+				markSynthetic(log);
+				rewriter.createBlock(&log.getBody());
+				rewriter.create<mlir::rlc::ClassFieldDeclaration>(
+						action.getLoc(),
+						mlir::rlc::ClassFieldDeclarationAttr::get(
+								undoLogSavedMember,
+								mlir::rlc::ScalarUseType::get(ctx, frameType.getName())));
+
+				// fun record_undo(Frame frame, <Frame>UndoLog log)
+				// fun undo(Frame frame, <Frame>UndoLog log)
+				rewriter.setInsertionPointAfter(log);
+				auto logType = mlir::rlc::ClassType::getIdentified(ctx, logName, {});
+				auto ftype = mlir::FunctionType::get(ctx, { frameType, logType }, {});
+				for (auto name : { recordUndoFunction, undoFunction })
+				{
+					auto fun = rewriter.create<mlir::rlc::FunctionOp>(
+							action.getLoc(),
+							name,
+							ftype,
+							mlir::rlc::FunctionInfoAttr::get(ctx, { "frame", "log" }),
+							false);
+					markSynthetic(fun);
+				}
+			}
+		}
+	};
+
+#define GEN_PASS_DEF_EMITUNDOLOGPASS
+#include "rlc/dialect/Passes.inc"
+
+	struct EmitUndoLogPass: impl::EmitUndoLogPassBase<EmitUndoLogPass>
+	{
+		void runOnOperation() override
+		{
+			mlir::IRRewriter rewriter(&getContext());
+			for (auto fun : undoLogFunctions(getOperation()))
+				if (fun.isDeclaration())
+					emitCopies(rewriter, fun);
+		}
+
+		private:
+		// fun record_undo(Frame frame, FrameUndoLog log):
+		//   log.saved.field = frame.field ...
+		// fun undo(Frame frame, FrameUndoLog log):
+		//   frame.field = log.saved.field ...
+		void emitCopies(mlir::IRRewriter& rewriter, mlir::rlc::FunctionOp fun)
+		{
+			auto loc = fun.getLoc();
+			auto type = fun.getArgumentTypes()[0].cast<mlir::rlc::ClassType>();
+			auto* block = rewriter.createBlock(
+					&fun.getBody(),
+					fun.getBody().begin(),
+					fun.getFunctionType().getInputs(),
+					{ loc, loc });
+			rewriter.setInsertionPointToStart(block);
+
+			auto frame = block->getArgument(0);
+			auto log = block->getArgument(1);
+			auto saved = rewriter.create<mlir::rlc::MemberAccess>(loc, log, 0);
+			bool restore = fun.getUnmangledName() == undoFunction;
+			for (size_t i = 0; i < type.getMembers().size(); i++)
+			{
+				auto fieldOfFrame =
+						rewriter.create<mlir::rlc::MemberAccess>(loc, frame, i);
+				auto fieldOfLog =
+						rewriter.create<mlir::rlc::MemberAccess>(loc, saved, i);
+				if (restore)
+					rewriter.create<mlir::rlc::AssignOp>(loc, fieldOfFrame, fieldOfLog);
+				else
+					rewriter.create<mlir::rlc::AssignOp>(loc, fieldOfLog, fieldOfFrame);
+			}
+			rewriter.create<mlir::rlc::Yield>(loc);
+		}
+	};
+
+#define GEN_PASS_DEF_PRUNEUNDOLOGPASS
+#include "rlc/dialect/Passes.inc"
+
+	struct PruneUndoLogPass: impl::PruneUndoLogPassBase<PruneUndoLogPass>
+	{
+		void runOnOperation() override
+		{
+			mlir::IRRewriter rewriter(&getContext());
+			for (auto fun : undoLogFunctions(getOperation()))
+			{
+				if (fun.isDeclaration())
+					continue;
+
+				auto type = fun.getArgumentTypes()[0].cast<mlir::rlc::ClassType>();
+				llvm::DenseSet<int64_t> written;
+				if (not collectWrittenFields(type, written))
+					continue;
+				pruneCopies(rewriter, fun, written);
+			}
+		}
+
+		private:
+		// collects the fields of frames of the given type that the action
+		// statement wrappers may write, returns false if the frame escapes
+		// somewhere the compiler can't follow, and thus anything may be written.
+		bool collectWrittenFields(
+				mlir::rlc::ClassType type, llvm::DenseSet<int64_t>& written)
+		{
+			// the resumption index is written by ActionStatementsToCoro, which
+			// runs after us.
+			written.insert(0);
+			llvm::DenseSet<std::pair<mlir::Operation*, unsigned>> visited;
+			for (auto fun : getOperation().getOps<mlir::rlc::FunctionOp>())
+			{
+				if (not isActionStatementWrapper(fun) or
+						fun.getArgumentTypes().empty() or
+						fun.getArgumentTypes()[0] != type)
+					continue;
+				if (not collectWrittenFields(fun, 0, written, visited))
+					return false;
+			}
+			return true;
+		}
+
+		bool collectWrittenFields(
+				mlir::rlc::FunctionOp fun,
+				unsigned index,
+				llvm::DenseSet<int64_t>& written,
+				llvm::DenseSet<std::pair<mlir::Operation*, unsigned>>& visited)
+		{
+			if (not visited.insert({ fun.getOperation(), index }).second)
+				return true;
+			if (fun.isDeclaration())
+				return false;
+
+			for (auto* region : { &fun.getBody(), &fun.getPrecondition() })
+			{
+				if (region->empty())
+					continue;
+				for (auto& use : region->front().getArgument(index).getUses())
+				{
+					auto* owner = use.getOwner();
+					if (auto access = mlir::dyn_cast<mlir::rlc::MemberAccess>(owner))
+					{
+						if (not readOnlyUses.isReadOnly(access.getResult()))
+							written.insert(access.getMemberIndex());
+						continue;
+					}
+
+					auto call = mlir::dyn_cast<mlir::rlc::CallOp>(owner);
+					if (call and use.getOperandNumber() != 0)
+					{
+						auto callee =
+								call.getCallee().getDefiningOp<mlir::rlc::FunctionOp>();
+						if (not callee or
+								not collectWrittenFields(
+										callee, use.getOperandNumber() - 1, written, visited))
+							return false;
+						continue;
+					}
+
+					if (not readOnlyUses.isReadOnly(use))
+						return false;
+				}
+			}
+			return true;
+		}
+
+		// erases the copies of the fields that are never written, each one is
+		// the only user of the access to the field of the frame argument.
+		void pruneCopies(
+				mlir::IRRewriter& rewriter,
+				mlir::rlc::FunctionOp fun,
+				const llvm::DenseSet<int64_t>& written)
+		{
+			llvm::SmallVector<mlir::rlc::MemberAccess, 4> toPrune;
+			for (auto* user : fun.getBody().front().getArgument(0).getUsers())
+				if (auto access = mlir::dyn_cast<mlir::rlc::MemberAccess>(user))
+					if (not written.contains(access.getMemberIndex()))
+						toPrune.push_back(access);
+
+			for (auto access : toPrune)
+			{
+				llvm::SmallVector<mlir::Operation*, 2> copies(access->getUsers());
+				for (auto* copy : copies)
+				{
+					llvm::SmallVector<mlir::rlc::MemberAccess, 2> operands;
+					for (auto operand : copy->getOperands())
+						if (auto def = operand.getDefiningOp<mlir::rlc::MemberAccess>())
+							operands.push_back(def);
+					rewriter.eraseOp(copy);
+					for (auto operand : operands)
+						if (operand->use_empty())
+							rewriter.eraseOp(operand);
+				}
+			}
+		}
+
+		ReadOnlyUses readOnlyUses;
+	};
+}	 // namespace mlir::rlc
@@ -28,6 +28,7 @@ namespace mlir::rlc
 			dumpMLIR,
 			compile,
 			executable,
+			jit,
 			format
 		};
 
@@ -43,7 +44,19 @@ namespace mlir::rlc
 
 		void setDumpIR(bool doDump) { dumpIR = doDump; }
 		void setClangPath(std::string newPath) { clangPath = newPath; }
+		void setModuleCache(std::string directory, std::string salt)
+		{
+			moduleCache = directory;
+			moduleCacheSalt = salt;
+		}
 		void setAbortSymbol(std::string abortSym) { abortSymbol = abortSym; }
+		void setRuntimeBitcode(std::string path) { runtimeBitcode = path; }
+		void setPGOGen(bool doIt, std::string outputFile = "")
+		{
+			pgoGen = doIt;
+			pgoGenFile = outputFile;
+		}
+		void setPGOUse(std::string profile) { pgoUse = profile; }
 		void setExtraObjectFile(std::vector<std::string> newExtraObjectFiles)
 		{
 			extraObjectFiles = newExtraObjectFiles;
@@ -63,12 +76,24 @@ namespace mlir::rlc
 		}
 
 		void setEmitBoundChecks(bool doEmit) { emitBoundChecks = doEmit; }
+		void setPruneActionEnumeration(bool doPrune)
+		{
+			pruneActionEnumeration = doPrune;
+		}
+		void setIncrementalHash(bool doIt) { incrementalHash = doIt; }
+		void setUndoLog(bool doIt) { undoLog = doIt; }
+		void setIncrementalObservation(bool doIt)
+		{
+			incrementalObservation = doIt;
+		}
 		void setEmitSanitizer(bool doEmit) { emitSanitizer = doEmit; }
 		void setEmitDependencyFile(bool doEmit) { emitDependencyFile = doEmit; }
 
 		void setSkipParsing(bool doIt = true) { skipParsing = doIt; }
 		void setDebug(bool doIt = true) { debug = doIt; }
 		void setVerbose(bool doIt = true) { verbose = doIt; }
+		void setJobs(unsigned count) { jobs = count; }
+		void setJitExitCode(int *out) { jitExitCode = out; }
 		void setHideStandardLibFiles(bool doIt = true)
 		{
 			hideStandardLibFiles = doIt;
@@ -95,6 +120,10 @@ namespace mlir::rlc
 		Request request = Request::executable;
 		bool emitPreconditionChecks = true;
 		bool emitBoundChecks = true;
+		bool pruneActionEnumeration = false;
+		bool incrementalHash = false;
+		bool undoLog = false;
+		bool incrementalObservation = false;
 		bool hideStandardLibFiles = true;
 		bool emitFuzzer = false;
 		bool emitSanitizer = false;
@@ -104,8 +133,14 @@ namespace mlir::rlc
 		bool keepComments = false;
 
 		std::string clangPath = "clang";
+		std::string moduleCache = "";
+		std::string moduleCacheSalt = "";
 
 		std::string abortSymbol = "";
+		std::string runtimeBitcode = "";
+		bool pgoGen = false;
+		std::string pgoGenFile = "";
+		std::string pgoUse = "";
 
 		llvm::SourceMgr *srcManager;
 		llvm::SmallVector<std::string, 2> inputFile;
@@ -117,6 +152,8 @@ namespace mlir::rlc
 		llvm::raw_ostream *OS;
 		bool dumpIR = false;
 		bool verbose = false;
+		unsigned jobs = 1;
+		int *jitExitCode = nullptr;
 
 		bool graphInlineCalls = false;
 		bool graphKeepOnlyActions = false;
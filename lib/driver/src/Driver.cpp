@@ -20,7 +20,10 @@ namespace mlir::rlc
 								inputFile,
 								srcManager,
 								keepComments,
-								emitDependencyFile ? outputFile : "" }));
+								emitDependencyFile ? outputFile : "",
+								moduleCache,
+								moduleCacheSalt,
+								verbose }));
 		}
 		if (request == Request::printIncludedFiles)
 		{
@@ -35,6 +38,12 @@ namespace mlir::rlc
 			return;
 		}
 
+		if (incrementalHash)
+			manager.addPass(mlir::rlc::createDeclareFrameHashPass());
+		if (undoLog)
+			manager.addPass(mlir::rlc::createDeclareUndoLogPass());
+		if (incrementalObservation)
+			manager.addPass(mlir::rlc::createDeclareIncrementalObservationPass());
 		manager.addPass(mlir::rlc::createEmitEnumEntitiesPass());
 		manager.addPass(mlir::rlc::createMemberFunctionsToRegularFunctionsPass());
 		manager.addPass(mlir::rlc::createTypeCheckEntitiesPass());
@@ -79,6 +88,13 @@ namespace mlir::rlc
 		manager.addPass(mlir::rlc::createLowerConstructOpPass());
 		manager.addPass(mlir::rlc::createLowerDestructorsPass());
 
+		if (incrementalHash)
+			manager.addPass(mlir::rlc::createEmitFrameHashPass());
+		if (undoLog)
+			manager.addPass(mlir::rlc::createEmitUndoLogPass());
+		if (incrementalObservation)
+			manager.addPass(mlir::rlc::createEmitIncrementalObservationPass());
+
 		if (request == Request::dumpBeforeTemplate)
 		{
 			manager.addPass(mlir::rlc::createPrintIRPass({ OS, hidePosition }));
@@ -148,6 +164,15 @@ namespace mlir::rlc
 			return;
 		}
 
+		if (incrementalHash)
+			manager.addPass(mlir::rlc::createIncrementalFrameHashPass());
+		if (undoLog)
+			manager.addPass(mlir::rlc::createPruneUndoLogPass());
+		if (incrementalObservation)
+			manager.addPass(mlir::rlc::createTrackObservationDirtyPass());
+		if (pruneActionEnumeration)
+			manager.addPass(mlir::rlc::createPruneActionEnumerationPass());
+		manager.addPass(mlir::rlc::createEmitLegalActionMaskPass());
 		manager.addPass(mlir::rlc::createExtractPreconditionPass());
 
 		if (emitPreconditionChecks)
@@ -170,11 +195,14 @@ namespace mlir::rlc
 			return;
 		}
 		manager.addPass(mlir::rlc::createLowerToLLVMPass({ debug, abortSymbol }));
-		manager.addPass(mlir::rlc::createRemoveUselessAllocaPass());
-		if (request == Request::executable and not emitFuzzer)
+		manager.addNestedPass<mlir::LLVM::LLVMFuncOp>(
+				mlir::rlc::createRemoveUselessAllocaPass());
+		if ((request == Request::executable or request == Request::jit) and
+				not emitFuzzer)
 			manager.addPass(mlir::rlc::createEmitMainPass({ debug }));
 		manager.addPass(mlir::createCanonicalizerPass());
-		manager.addPass(mlir::rlc::createHoistAllocaPass());
+		manager.addNestedPass<mlir::LLVM::LLVMFuncOp>(
+				mlir::rlc::createHoistAllocaPass());
 
 		if (request == Request::dumpMLIR)
 		{
@@ -195,7 +223,14 @@ namespace mlir::rlc
 																							emitFuzzer,
 																							&rPath,
 																							targetInfo,
-																							verbose }));
+																							verbose,
+																							jobs,
+																							Request::jit == request,
+																							jitExitCode,
+																							runtimeBitcode,
+																							pgoGen,
+																							pgoGenFile,
+																							pgoUse }));
 	}
 
 }	 // namespace mlir::rlc
@@ -39,6 +39,7 @@ namespace rlc
 		KeywordRule,
 		KeywordEnum,
 		KeywordMalloc,
+		KeywordRealloc,
 		KeywordAssert,
 		KeywordDestroy,
 		KeywordContstruct,
@@ -51,6 +52,12 @@ namespace rlc
 		KeywordMangledName,
 		KeywordActionClass,
 		KeywordAsPtr,
+		KeywordMatchGroup,
+		KeywordHashBytes,
+		KeywordIsPlainData,
+		KeywordSizeOf,
+		KeywordCopyBytes,
+		KeywordStoreFloat32,
 		KeywordToArray,
 		KeywordFromArray,
 		KeywordEvent,
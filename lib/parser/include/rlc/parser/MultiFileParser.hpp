@@ -59,6 +59,22 @@ namespace rlc
 			return llvm::Error::success();
 		}
 
+		// parses the file, or loads it from the module cache if one is set and
+		// it holds a entry for the same content, path and compiler.
+		llvm::Error parseOneFileCached(
+				llvm::StringRef content,
+				llvm::StringRef fileName,
+				llvm::SmallVector<std::string>& fileToLoad);
+
+		// files parsed once are stored in `directory` as bytecode, keyed by
+		// their content, their path and `salt`, which must change every time
+		// the parser does.
+		void setModuleCache(llvm::StringRef directory, llvm::StringRef salt)
+		{
+			cacheDirectory = directory.str();
+			cacheSalt = salt.str();
+		}
+
 		llvm::Expected<mlir::ModuleOp> parseFromBuffer(
 				llvm::StringRef content, llvm::StringRef fileName)
 		{
@@ -112,8 +128,8 @@ namespace rlc
 				includedFiles.push_back(AbslutePath);
 
 				alreadyLoaded.insert(AbslutePath);
-				if (auto error = parseOneFile(
-								sourceManager->getMemoryBuffer(id)->getBuffer().str(),
+				if (auto error = parseOneFileCached(
+								sourceManager->getMemoryBuffer(id)->getBuffer(),
 								AbslutePath,
 								fileToLoad))
 				{
@@ -147,12 +163,29 @@ namespace rlc
 			return includedFiles;
 		}
 
+		// how many files have been loaded from the module cache, and how many
+		// had to be parsed because they were not there.
+		size_t getCacheHits() const { return cacheHits; }
+		size_t getCacheMisses() const { return cacheMisses; }
+
 		private:
+		std::string cachePath(llvm::StringRef content, llvm::StringRef fileName);
+		bool loadFromCache(
+				llvm::StringRef path, llvm::SmallVector<std::string>& fileToLoad);
+		void storeInCache(
+				llvm::StringRef path,
+				mlir::ModuleOp parsed,
+				llvm::ArrayRef<std::string> importedFiles);
+
 		llvm::SourceMgr* sourceManager;
 		mlir::MLIRContext* context;
 		mlir::ModuleOp module;
 		llvm::SmallVector<std::string, 4> includedFiles;
 		bool keepComments;
+		std::string cacheDirectory;
+		std::string cacheSalt;
+		size_t cacheHits = 0;
+		size_t cacheMisses = 0;
 	};
 
 }	 // namespace rlc
@@ -56,12 +56,19 @@ namespace rlc
 		llvm::Expected<mlir::rlc::AssertOp> assertStatement();
 		llvm::Expected<mlir::Value> canCallExpression();
 		llvm::Expected<mlir::Value> builtinMalloc();
+		llvm::Expected<mlir::Value> builtinRealloc();
 		llvm::Expected<mlir::Value> builtinFromArray();
 		llvm::Expected<mlir::Value> builtinToArray();
 		llvm::Expected<mlir::rlc::FreeOp> builtinFree();
 		llvm::Expected<mlir::Operation*> builtinDestroy();
 		llvm::Expected<mlir::Value> builtinMangledName();
 		llvm::Expected<mlir::Value> builtinAsPtr();
+		llvm::Expected<mlir::Value> builtinMatchGroup();
+		llvm::Expected<mlir::Value> builtinHashBytes();
+		llvm::Expected<mlir::Value> builtinIsPlainData();
+		llvm::Expected<mlir::Value> builtinSizeOf();
+		llvm::Expected<mlir::rlc::BuiltinCopyBytesOp> builtinCopyBytes();
+		llvm::Expected<mlir::rlc::BuiltinStoreFloat32Op> builtinStoreFloat32();
 		llvm::Expected<mlir::Operation*> builtinConstruct();
 		llvm::Expected<mlir::Value> expression();
 		llvm::Expected<mlir::Value> unaryExpression();
@@ -89,6 +89,18 @@ llvm::StringRef rlc::tokenToString(Token t)
 			return "KeywordMangledName";
 		case Token::KeywordAsPtr:
 			return "KeywordAsPtr";
+		case Token::KeywordMatchGroup:
+			return "KeywordMatchGroup";
+		case Token::KeywordHashBytes:
+			return "KeywordHashBytes";
+		case Token::KeywordIsPlainData:
+			return "KeywordIsPlainData";
+		case Token::KeywordSizeOf:
+			return "KeywordSizeOf";
+		case Token::KeywordCopyBytes:
+			return "KeywordCopyBytes";
+		case Token::KeywordStoreFloat32:
+			return "KeywordStoreFloat32";
 		case Token::KeywordTrait:
 			return "KeywordTrait";
 		case Token::KeywordIs:
@@ -139,6 +151,8 @@ llvm::StringRef rlc::tokenToString(Token t)
 			return "KeywordImport";
 		case Token::KeywordMalloc:
 			return "KeywordMalloc";
+		case Token::KeywordRealloc:
+			return "KeywordRealloc";
 		case Token::KeywordUsing:
 			return "KeywordUsing";
 		case Token::KeywordAlternative:
@@ -572,6 +586,9 @@ Token Lexer::eatIdent()
 	if (name == "__builtin_malloc_do_not_use")
 		return Token::KeywordMalloc;
 
+	if (name == "__builtin_realloc_do_not_use")
+		return Token::KeywordRealloc;
+
 	if (name == "__builtin_destroy_do_not_use")
 		return Token::KeywordDestroy;
 
@@ -596,6 +613,24 @@ Token Lexer::eatIdent()
 	if (name == "__builtin_as_ptr_do_not_use")
 		return Token::KeywordAsPtr;
 
+	if (name == "__builtin_match_group_do_not_use")
+		return Token::KeywordMatchGroup;
+
+	if (name == "__builtin_hash_bytes_do_not_use")
+		return Token::KeywordHashBytes;
+
+	if (name == "__builtin_is_plain_data_do_not_use")
+		return Token::KeywordIsPlainData;
+
+	if (name == "__builtin_size_of_do_not_use")
+		return Token::KeywordSizeOf;
+
+	if (name == "__builtin_copy_bytes_do_not_use")
+		return Token::KeywordCopyBytes;
+
+	if (name == "__builtin_store_float32_do_not_use")
+		return Token::KeywordStoreFloat32;
+
 	lIdent = name;
 	return Token::Identifier;
 }
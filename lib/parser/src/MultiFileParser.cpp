@@ -15,16 +15,138 @@ limitations under the License.
 */
 #include "rlc/parser/MultiFileParser.hpp"
 
+#include "llvm/ADT/StringExtras.h"
 #include "llvm/ADT/TypeSwitch.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/ToolOutputFile.h"
+#include "llvm/Support/xxhash.h"
+#include "mlir/Bytecode/BytecodeWriter.h"
 #include "mlir/IR/BuiltinDialect.h"
+#include "mlir/IR/Diagnostics.h"
+#include "mlir/IR/OwningOpRef.h"
+#include "mlir/Parser/Parser.h"
 #include "mlir/Pass/Pass.h"
 #include "rlc/dialect/Operations.hpp"
 #include "rlc/dialect/Passes.hpp"
 #include "rlc/utils/Error.hpp"
 
+namespace rlc
+{
+	static constexpr llvm::StringLiteral importedFilesAttr = "rlc.imported_files";
+
+	llvm::Error MultiFileParser::parseOneFileCached(
+			llvm::StringRef content,
+			llvm::StringRef fileName,
+			llvm::SmallVector<std::string>& fileToLoad)
+	{
+		if (cacheDirectory.empty())
+			return parseOneFile(content, fileName, fileToLoad);
+
+		auto path = cachePath(content, fileName);
+		if (loadFromCache(path, fileToLoad))
+		{
+			cacheHits++;
+			return llvm::Error::success();
+		}
+		cacheMisses++;
+
+		// the file is parsed in a module of its own, so that it can be stored
+		// alone, and then moved where the parser would have put it, before the
+		// files parsed so far.
+		mlir::OwningOpRef<mlir::ModuleOp> parsed(
+				mlir::ModuleOp::create(mlir::UnknownLoc::get(context)));
+		Parser parser(context, content.str(), fileName.str(), keepComments);
+		auto maybeAst = parser.system(*parsed);
+		for (auto file : parser.getImportedFiles())
+			fileToLoad.push_back(file);
+		if (maybeAst)
+			storeInCache(path, *parsed, parser.getImportedFiles());
+
+		auto& operations = module.getBody()->getOperations();
+		operations.splice(operations.begin(), parsed->getBody()->getOperations());
+		if (not maybeAst)
+			return maybeAst.takeError();
+		return llvm::Error::success();
+	}
+
+	std::string MultiFileParser::cachePath(
+			llvm::StringRef content, llvm::StringRef fileName)
+	{
+		std::string key;
+		llvm::raw_string_ostream OS(key);
+		OS << cacheSalt << '\0' << fileName << '\0' << keepComments << '\0'
+			 << content;
+		OS.flush();
+
+		llvm::SmallString<128> path(cacheDirectory);
+		llvm::sys::path::append(
+				path,
+				llvm::utohexstr(llvm::xxh3_64bits(llvm::arrayRefFromStringRef(key))) +
+						".mlirbc");
+		return path.str().str();
+	}
+
+	// entries that can't be read, such as the ones written by a different
+	// compiler, are treated as missing and the file is parsed again.
+	bool MultiFileParser::loadFromCache(
+			llvm::StringRef path, llvm::SmallVector<std::string>& fileToLoad)
+	{
+		if (not llvm::sys::fs::exists(path))
+			return false;
+
+		mlir::ScopedDiagnosticHandler silenceErrors(
+				context, [](mlir::Diagnostic&) { return mlir::success(); });
+		mlir::ParserConfig config(context);
+		auto cached = mlir::parseSourceFile<mlir::ModuleOp>(path, config);
+		if (not cached)
+			return false;
+		auto imported =
+				(*cached)->getAttrOfType<mlir::ArrayAttr>(importedFilesAttr);
+		if (not imported)
+			return false;
+
+		for (auto file : imported.getAsRange<mlir::StringAttr>())
+			fileToLoad.push_back(file.str());
+		auto& operations = module.getBody()->getOperations();
+		operations.splice(operations.begin(), cached->getBody()->getOperations());
+		return true;
+	}
+
+	// the entry is written to a unique file and then renamed, so that
+	// concurrent compilations never read a partial one. Failing to store it
+	// is not a error, the file will just be parsed again next time.
+	void MultiFileParser::storeInCache(
+			llvm::StringRef path,
+			mlir::ModuleOp parsed,
+			llvm::ArrayRef<std::string> importedFiles)
+	{
+		if (llvm::sys::fs::create_directories(cacheDirectory))
+			return;
+
+		llvm::SmallVector<mlir::Attribute, 4> imported;
+		for (const auto& file : importedFiles)
+			imported.push_back(mlir::StringAttr::get(context, file));
+		parsed->setAttr(importedFilesAttr, mlir::ArrayAttr::get(context, imported));
+
+		int fd;
+		llvm::SmallString<128> temporary;
+		if (llvm::sys::fs::createUniqueFile(path + ".%%%%%%", fd, temporary))
+			return;
+
+		bool failed = false;
+		{
+			llvm::raw_fd_ostream OS(fd, true);
+			failed = mlir::writeBytecodeToFile(parsed, OS).failed();
+			OS.close();
+			failed = failed or OS.has_error();
+			OS.clear_error();
+		}
+		if (failed or llvm::sys::fs::rename(temporary, path))
+			llvm::sys::fs::remove(temporary);
+	}
+}	 // namespace rlc
+
 namespace mlir::rlc
 {
 
@@ -70,6 +192,8 @@ namespace mlir::rlc
 					srcManager,
 					getOperation(),
 					keepComments);
+			if (moduleCache != "")
+				parser.setModuleCache(moduleCache, moduleCacheSalt);
 
 			auto maybeAst = parser.parse(inputs);
 			if (not handleErrors(getContext(), maybeAst))
@@ -78,6 +202,10 @@ namespace mlir::rlc
 				return;
 			}
 
+			if (verbose and moduleCache != "")
+				llvm::errs() << "module cache: " << parser.getCacheHits() << " hits, "
+										 << parser.getCacheMisses() << " misses\n";
+
 			if (dependencyFile != "")
 			{
 				std::error_code EC;
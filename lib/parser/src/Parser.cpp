@@ -240,6 +240,68 @@ Expected<mlir::Value> Parser::builtinAsPtr()
 	return builder.create<mlir::rlc::BuiltinAsPtr>(location, *arg);
 }
 
+// builtinMatchGroup : "__builtin_match_group_do_not_use(" expression ","
+// expression "," expression ")"
+Expected<mlir::Value> Parser::builtinMatchGroup()
+{
+	auto location = getCurrentSourcePos();
+	EXPECT(Token::KeywordMatchGroup);
+	EXPECT(Token::LPar);
+	TRY(control, expression());
+	EXPECT(Token::Comma);
+	TRY(index, expression());
+	EXPECT(Token::Comma);
+	TRY(tag, expression());
+	EXPECT(Token::RPar);
+
+	return builder.create<mlir::rlc::BuiltinMatchGroupOp>(
+			location, *control, *index, *tag);
+}
+
+// builtinHashBytes : "__builtin_hash_bytes_do_not_use(" expression (","
+// expression)? ")"
+Expected<mlir::Value> Parser::builtinHashBytes()
+{
+	auto location = getCurrentSourcePos();
+	EXPECT(Token::KeywordHashBytes);
+	EXPECT(Token::LPar);
+	TRY(value, expression());
+	if (accept<Token::Comma>())
+	{
+		TRY(count, expression());
+		EXPECT(Token::RPar);
+		return builder.create<mlir::rlc::BuiltinHashBytesOp>(
+				location, *value, *count);
+	}
+	EXPECT(Token::RPar);
+
+	return builder.create<mlir::rlc::BuiltinHashBytesOp>(location, *value);
+}
+
+// builtinIsPlainData : "__builtin_is_plain_data_do_not_use(" expression ")"
+Expected<mlir::Value> Parser::builtinIsPlainData()
+{
+	auto location = getCurrentSourcePos();
+	EXPECT(Token::KeywordIsPlainData);
+	EXPECT(Token::LPar);
+	TRY(value, expression());
+	EXPECT(Token::RPar);
+
+	return builder.create<mlir::rlc::BuiltinIsPlainDataOp>(location, *value);
+}
+
+// builtinSizeOf : "__builtin_size_of_do_not_use(" expression ")"
+Expected<mlir::Value> Parser::builtinSizeOf()
+{
+	auto location = getCurrentSourcePos();
+	EXPECT(Token::KeywordSizeOf);
+	EXPECT(Token::LPar);
+	TRY(value, expression());
+	EXPECT(Token::RPar);
+
+	return builder.create<mlir::rlc::BuiltinSizeOfOp>(location, *value);
+}
+
 // builtinMalloc : "__builtin_destroy_do_not_use(" expression ")"
 Expected<mlir::Operation*> Parser::builtinDestroy()
 {
@@ -283,6 +345,25 @@ Expected<mlir::Value> Parser::builtinMalloc()
 			*shugarType);
 }
 
+// builtinRealloc : "__builtin_realloc_do_not_use(" expression "," expression
+// ")"
+Expected<mlir::Value> Parser::builtinRealloc()
+{
+	auto location = getCurrentSourcePos();
+	EXPECT(Token::KeywordRealloc);
+	EXPECT(Token::LPar);
+	TRY(toResize, expression());
+	EXPECT(Token::Comma);
+	TRY(size, expression());
+	EXPECT(Token::RPar);
+
+	return builder.create<mlir::rlc::ReallocOp>(
+			location,
+			mlir::rlc::UnknownType::get(builder.getContext()),
+			*toResize,
+			*size);
+}
+
 // builtinFree : "__builtin_free_do_not_use(" expression ")\n"
 Expected<mlir::rlc::FreeOp> Parser::builtinFree()
 {
@@ -295,6 +376,40 @@ Expected<mlir::rlc::FreeOp> Parser::builtinFree()
 	return builder.create<mlir::rlc::FreeOp>(location, *toDelete);
 }
 
+// builtinCopyBytes : "__builtin_copy_bytes_do_not_use(" expression ","
+// expression "," expression ")\n"
+Expected<mlir::rlc::BuiltinCopyBytesOp> Parser::builtinCopyBytes()
+{
+	auto location = getCurrentSourcePos();
+	EXPECT(Token::KeywordCopyBytes);
+	EXPECT(Token::LPar);
+	TRY(destination, expression());
+	EXPECT(Token::Comma);
+	TRY(source, expression());
+	EXPECT(Token::Comma);
+	TRY(size, expression());
+	EXPECT(Token::RPar);
+
+	return builder.create<mlir::rlc::BuiltinCopyBytesOp>(
+			location, *destination, *source, *size);
+}
+
+// builtinStoreFloat32 : "__builtin_store_float32_do_not_use(" expression ","
+// expression ")\n"
+Expected<mlir::rlc::BuiltinStoreFloat32Op> Parser::builtinStoreFloat32()
+{
+	auto location = getCurrentSourcePos();
+	EXPECT(Token::KeywordStoreFloat32);
+	EXPECT(Token::LPar);
+	TRY(destination, expression());
+	EXPECT(Token::Comma);
+	TRY(value, expression());
+	EXPECT(Token::RPar);
+
+	return builder.create<mlir::rlc::BuiltinStoreFloat32Op>(
+			location, *destination, *value);
+}
+
 /**
  * primaryExpression : Ident ("::" Ident)? | Double | int64 | "true" | "false" |
  * "(" expression ")"  | builtinMalloc | builtinFromArray | builtinToArray |
@@ -345,6 +460,9 @@ Expected<mlir::Value> Parser::primaryExpression()
 	if (current == Token::KeywordMalloc)
 		return builtinMalloc();
 
+	if (current == Token::KeywordRealloc)
+		return builtinRealloc();
+
 	if (current == Token::KeywordFromArray)
 		return builtinFromArray();
 
@@ -354,6 +472,18 @@ Expected<mlir::Value> Parser::primaryExpression()
 	if (current == Token::KeywordAsPtr)
 		return builtinAsPtr();
 
+	if (current == Token::KeywordMatchGroup)
+		return builtinMatchGroup();
+
+	if (current == Token::KeywordHashBytes)
+		return builtinHashBytes();
+
+	if (current == Token::KeywordIsPlainData)
+		return builtinIsPlainData();
+
+	if (current == Token::KeywordSizeOf)
+		return builtinSizeOf();
+
 	if (current == Token::String)
 		return stringExpression();
 
@@ -976,6 +1106,14 @@ llvm::Expected<mlir::rlc::ExpressionStatement> Parser::expressionStatement()
 	{
 		TRY(_, builtinFree(), onExit());
 	}
+	else if (current == Token::KeywordCopyBytes)
+	{
+		TRY(_, builtinCopyBytes(), onExit());
+	}
+	else if (current == Token::KeywordStoreFloat32)
+	{
+		TRY(_, builtinStoreFloat32(), onExit());
+	}
 	else if (current == Token::KeywordDestroy)
 	{
 		TRY(_, builtinDestroy(), onExit());
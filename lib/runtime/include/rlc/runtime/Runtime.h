@@ -62,3 +62,6 @@ EXPORT void rl_is_alphanumeric__int8_t_r_bool(
 // fun load_file(String file_path, String out) -> Bool
 EXPORT void rl_load_file__String_r_String(
 		int8_t* result, String* file_name, String* out);
+
+// __builtin_hash_bytes_do_not_use, hashes size bytes starting at data
+EXPORT int64_t rlc_hash_bytes(const void* data, int64_t size);
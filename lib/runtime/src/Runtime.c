@@ -171,3 +171,116 @@ void rl_load_file__String_String_r_bool(
 	fclose(f);
 	*result = 1;
 }
+
+// wyhash style hashing of memory ranges. Every step multiplies two 64 bit
+// words into 128 bits and folds the result, so that each input bit affects
+// every output bit.
+static const uint64_t rlc_hash_secret[4] = { 0xa0761d6478bd642full,
+																						 0xe7037ed1a0b428dbull,
+																						 0x8ebc6af09c88c6e3ull,
+																						 0x589965cc75374cc3ull };
+
+static void rlc_hash_multiply(uint64_t* a, uint64_t* b)
+{
+#if defined(__SIZEOF_INT128__)
+	__uint128_t result = (__uint128_t) *a * *b;
+	*a = (uint64_t) result;
+	*b = (uint64_t) (result >> 64);
+#else
+	uint64_t highA = *a >> 32, highB = *b >> 32;
+	uint64_t lowA = (uint32_t) *a, lowB = (uint32_t) *b;
+	uint64_t high = highA * highB, middle0 = highA * lowB;
+	uint64_t middle1 = highB * lowA, low = lowA * lowB;
+	uint64_t partial = low + (middle0 << 32);
+	uint64_t carry = partial < low;
+	uint64_t lowResult = partial + (middle1 << 32);
+	carry += lowResult < partial;
+	*a = lowResult;
+	*b = high + (middle0 >> 32) + (middle1 >> 32) + carry;
+#endif
+}
+
+static uint64_t rlc_hash_mix(uint64_t a, uint64_t b)
+{
+	rlc_hash_multiply(&a, &b);
+	return a ^ b;
+}
+
+static uint64_t rlc_hash_read8(const uint8_t* p)
+{
+	uint64_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+static uint64_t rlc_hash_read4(const uint8_t* p)
+{
+	uint32_t value;
+	memcpy(&value, p, sizeof(value));
+	return value;
+}
+
+int64_t rlc_hash_bytes(const void* data, int64_t size)
+{
+	const uint8_t* p = (const uint8_t*) data;
+	uint64_t length = (uint64_t) size;
+	uint64_t seed = rlc_hash_secret[0] ^
+									rlc_hash_mix(rlc_hash_secret[0], rlc_hash_secret[1]);
+	uint64_t a = 0;
+	uint64_t b = 0;
+	if (length <= 16)
+	{
+		if (length >= 4)
+		{
+			uint64_t middle = (length >> 3) << 2;
+			a = (rlc_hash_read4(p) << 32) | rlc_hash_read4(p + middle);
+			b = (rlc_hash_read4(p + length - 4) << 32) |
+					rlc_hash_read4(p + length - 4 - middle);
+		}
+		else if (length > 0)
+		{
+			a = ((uint64_t) p[0] << 16) | ((uint64_t) p[length >> 1] << 8) |
+					p[length - 1];
+		}
+	}
+	else
+	{
+		uint64_t remaining = length;
+		if (remaining > 48)
+		{
+			uint64_t seed1 = seed;
+			uint64_t seed2 = seed;
+			do
+			{
+				seed = rlc_hash_mix(
+						rlc_hash_read8(p) ^ rlc_hash_secret[1],
+						rlc_hash_read8(p + 8) ^ seed);
+				seed1 = rlc_hash_mix(
+						rlc_hash_read8(p + 16) ^ rlc_hash_secret[2],
+						rlc_hash_read8(p + 24) ^ seed1);
+				seed2 = rlc_hash_mix(
+						rlc_hash_read8(p + 32) ^ rlc_hash_secret[3],
+						rlc_hash_read8(p + 40) ^ seed2);
+				p += 48;
+				remaining -= 48;
+			} while (remaining > 48);
+			seed ^= seed1 ^ seed2;
+		}
+		while (remaining > 16)
+		{
+			seed = rlc_hash_mix(
+					rlc_hash_read8(p) ^ rlc_hash_secret[1],
+					rlc_hash_read8(p + 8) ^ seed);
+			p += 16;
+			remaining -= 16;
+		}
+		a = rlc_hash_read8(p + remaining - 16);
+		b = rlc_hash_read8(p + remaining - 8);
+	}
+
+	a ^= rlc_hash_secret[1];
+	b ^= seed;
+	rlc_hash_multiply(&a, &b);
+	return (int64_t) rlc_hash_mix(
+			a ^ rlc_hash_secret[0] ^ length, b ^ rlc_hash_secret[1]);
+}
@@ -16,15 +16,22 @@ limitations under the License.
 #pragma once
 
 #include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
+#include <condition_variable>
+#include <cstdlib>
+#include <functional>
 #include <iostream>
 #include <limits>
 #include <memory>
 #include <mutex>
-#include <numeric>
+#include <new>
+#include <optional>
 #include <random>
 #include <thread>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 AnyGameAction action;
@@ -87,250 +94,1025 @@ class GameState
 		return score(state, val);
 	}
 
+	size_t observationSize() const { return observation_tensor_size(state); }
+
+	// writes the observation tensor of the state, as seen by the player that
+	// is about to act, into out, which must hold observationSize() floats
+	void writeObservation(float* out) const
+	{
+		static thread_local VectorTdoubleT tensor;
+		int64_t size = observation_tensor_size(state);
+		if (tensor.size() != size)
+			tensor.resize(size);
+		to_observation_tensor(state, owner_id, tensor);
+		for (int64_t i = 0; i != size; i++)
+			out[i] = *tensor.get(i);
+	}
+
 	void dump() const { pretty_print(state); }
 };
 
+// atomic<double>::fetch_add is not available in every standard library we
+// build against
+inline void atomicAdd(std::atomic<double>& value, double delta)
+{
+	double expected = value.load(std::memory_order_relaxed);
+	while (not value.compare_exchange_weak(
+			expected, expected + delta, std::memory_order_relaxed))
+		;
+}
+
+// A fixed size table of statistics about the states reached by searches,
+// indexed by their hash, so that the same state reached by different
+// sequences of moves shares what has been learned about it, including across
+// moves of a game.
+//
+// The table is split into shards, each protected by its own lock, so that
+// threads touching different states rarely contend. A state can be stored in
+// any of a few consecutive slots of its shard. When all of them are taken the
+// slot holding the least useful entry is replaced: first entries left over by
+// previous searches, then the ones with fewer visits.
+//
+// Rewards are stored as seen by player zero, it is up to the caller to flip
+// them for the player that is choosing.
+class MCTSTranspositionTable
+{
+	public:
+	struct Stats
+	{
+		int64_t visits = 0;
+		double reward = 0;
+	};
+
+	explicit MCTSTranspositionTable(
+			size_t entryCount = 1 << 20, size_t shardCount = 64)
+			: shardCount(shardCount),
+				entriesPerShard(std::max<size_t>(probes, entryCount / shardCount)),
+				shards(std::make_unique<Shard[]>(shardCount))
+	{
+		for (size_t i = 0; i != shardCount; i++)
+			shards[i].entries.resize(entriesPerShard);
+	}
+
+	// records that the state with the given hash has been reached at depth
+	// during the current search and returns what is known about it, or
+	// nothing if the current search already reached it at a lower depth and
+	// it should not be searched again.
+	std::optional<Stats> reach(uint64_t hash, size_t depth)
+	{
+		auto& shard = shardOf(hash);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		auto& entry = findOrReplace(shard, hash);
+		if (entry.generation == generation and entry.depth < depth)
+			return std::nullopt;
+		entry.generation = generation;
+		entry.depth = depth;
+		return Stats{ entry.visits, entry.reward };
+	}
+
+	// adds the result of a simulation that went through the state, if the
+	// table still holds it.
+	void update(uint64_t hash, double reward)
+	{
+		auto& shard = shardOf(hash);
+		std::lock_guard<std::mutex> lock(shard.mutex);
+		if (auto* entry = find(shard, hash))
+		{
+			entry->visits++;
+			entry->reward += reward;
+		}
+	}
+
+	// invoked when the root of the search changes. Statistics are kept, while
+	// the depths at which states have been reached are forgotten, since they
+	// are relative to the old root.
+	void newGeneration() { generation++; }
+
+	void clear()
+	{
+		for (size_t i = 0; i != shardCount; i++)
+		{
+			std::lock_guard<std::mutex> lock(shards[i].mutex);
+			std::fill(shards[i].entries.begin(), shards[i].entries.end(), Entry());
+		}
+	}
+
+	private:
+	static constexpr size_t probes = 4;
+
+	struct Entry
+	{
+		uint64_t key = 0;
+		bool used = false;
+		uint32_t generation = 0;
+		size_t depth = 0;
+		int64_t visits = 0;
+		double reward = 0;
+	};
+
+	struct Shard
+	{
+		std::mutex mutex;
+		std::vector<Entry> entries;
+	};
+
+	// the hashes emitted by rlc are not guaranteed to be well distributed in
+	// their low bits, so they are mixed before being used as an index.
+	static uint64_t mix(uint64_t hash)
+	{
+		hash ^= hash >> 30;
+		hash *= 0xbf58476d1ce4e5b9ULL;
+		hash ^= hash >> 27;
+		hash *= 0x94d049bb133111ebULL;
+		return hash ^ (hash >> 31);
+	}
+
+	Shard& shardOf(uint64_t hash) { return shards[mix(hash) % shardCount]; }
+
+	size_t firstSlot(uint64_t hash) const
+	{
+		return (mix(hash) / shardCount) % entriesPerShard;
+	}
+
+	Entry* find(Shard& shard, uint64_t hash)
+	{
+		auto first = firstSlot(hash);
+		for (size_t i = 0; i != probes; i++)
+		{
+			auto& entry = shard.entries[(first + i) % entriesPerShard];
+			if (entry.used and entry.key == hash)
+				return &entry;
+		}
+		return nullptr;
+	}
+
+	Entry& findOrReplace(Shard& shard, uint64_t hash)
+	{
+		if (auto* entry = find(shard, hash))
+			return *entry;
+
+		auto first = firstSlot(hash);
+		Entry* victim = &shard.entries[first];
+		for (size_t i = 0; i != probes; i++)
+		{
+			auto& entry = shard.entries[(first + i) % entriesPerShard];
+			if (not entry.used)
+			{
+				victim = &entry;
+				break;
+			}
+			bool entryIsStale = entry.generation != generation;
+			bool victimIsStale = victim->generation != generation;
+			if (entryIsStale != victimIsStale)
+			{
+				if (entryIsStale)
+					victim = &entry;
+			}
+			else if (entry.visits < victim->visits)
+				victim = &entry;
+		}
+
+		*victim = Entry();
+		victim->used = true;
+		victim->key = hash;
+		// a fresh entry has never been reached during this generation
+		victim->generation = generation - 1;
+		return *victim;
+	}
+
+	size_t shardCount;
+	size_t entriesPerShard;
+	std::unique_ptr<Shard[]> shards;
+	std::atomic<uint32_t> generation = 1;
+};
+
 // MCTS Node
-template<typename State>
+//
+// Nodes are shared by all the threads of a search. Statistics are atomic and
+// a node is expanded exactly once, by the first thread that reaches it, which
+// creates all of its children before publishing them. Threads that reach a
+// node while it is being expanded treat it as a leaf.
+//
+// While a thread is descending through a node it adds a virtual loss to it,
+// so that concurrent selections are steered towards different paths. The
+// virtual loss is removed when the result of the simulation is propagated
+// back.
+//
+// Nodes refer to each other with 32 bit indices into a MCTSNodePool, the
+// children of a node are contiguous. When StoreStates is false the node only
+// holds the action that leads to it from its parent, and its state is
+// rebuilt by replaying the actions from the root.
+template<typename State, bool StoreStates>
 class MCTSNode
 {
 	public:
-	MCTSNode(const State& state, MCTSNode* parent = nullptr)
-			: state(state), parent(parent), visits(0), reward(0.0)
+	using Action = typename State::Action;
+	static constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+	enum class Expansion : uint8_t
+	{
+		unexpanded,
+		expanding,
+		expanded
+	};
+
+	struct NoState
+	{
+	};
+
+	template<typename... StateArgs>
+	MCTSNode(
+			uint32_t parent,
+			Action action,
+			uint32_t depth,
+			int64_t stateHash,
+			int64_t player,
+			StateArgs&&... stateArgs)
+			: parent(parent),
+				depth(depth),
+				action(action),
+				stateHash(stateHash),
+				player(player),
+				state(std::forward<StateArgs>(stateArgs)...)
 	{
 	}
 
-	MCTSNode* select();
-	void expand();
-	double simulate(uint64_t num_threads);
-	void simulate_woker(double* result);
-	void backpropagate(double reward);
+	bool isExpanded() const
+	{
+		return expansion.load(std::memory_order_acquire) == Expansion::expanded;
+	}
 
-	State state;
-	MCTSNode* parent;
-	std::vector<std::unique_ptr<MCTSNode>> children;
-	int visits;
-	size_t depth = 0;
-	double reward;
-	std::vector<typename State::Action> untriedActions;
+	// the upper confidence bound of this node, counting the virtual losses of
+	// the threads currently descending through it as lost simulations
+	double uct(double logParentVisits) const
+	{
+		double virtualLosses = virtualLoss.load(std::memory_order_relaxed);
+		double count = visits.load(std::memory_order_relaxed) + virtualLosses;
+		if (count == 0)
+			return std::numeric_limits<double>::infinity();
+		return (reward.load(std::memory_order_relaxed) - virtualLosses) / count +
+					 std::sqrt(2 * logParentVisits / count);
+	}
 
-	void dumpDot()
+	// the PUCT score of this node, exploration is weighted by the prior the
+	// evaluator assigned to the action leading here
+	double puct(double sqrtParentVisits, double exploration) const
+	{
+		double virtualLosses = virtualLoss.load(std::memory_order_relaxed);
+		double count = visits.load(std::memory_order_relaxed) + virtualLosses;
+		double value =
+				count == 0
+						? 0
+						: (reward.load(std::memory_order_relaxed) - virtualLosses) / count;
+		return value + exploration * prior * sqrtParentVisits / (1 + count);
+	}
+
+	std::atomic<int64_t> visits = 0;
+	std::atomic<int64_t> virtualLoss = 0;
+	std::atomic<double> reward = 0.0;
+	std::atomic<Expansion> expansion = Expansion::unexpanded;
+	uint32_t parent;
+	uint32_t firstChild = 0;
+	uint32_t childCount = 0;
+	uint32_t depth;
+	float prior = 0;
+	Action action;
+	int64_t stateHash;
+	// the player that chooses the next action from this node
+	int64_t player;
+	[[no_unique_address]] std::conditional_t<StoreStates, State, NoState> state;
+};
+
+// Stores the nodes of a search tree in large chunks that are never moved nor
+// freed until the pool is cleared, so that expanding a node costs a single
+// reservation of a block of contiguous slots and no call to malloc most of
+// the times. Nodes can be read by a thread while another one reserves new
+// slots.
+template<typename Node>
+class MCTSNodePool
+{
+	public:
+	static constexpr uint32_t chunkBits = 14;
+	static constexpr uint32_t chunkSize = 1u << chunkBits;
+	static constexpr uint32_t maxChunks = 1u << (32 - chunkBits);
+
+	MCTSNodePool()
+			: chunks(std::make_unique<std::atomic<Node*>[]>(maxChunks)),
+				constructed(maxChunks, 0)
+	{
+	}
+
+	~MCTSNodePool()
+	{
+		clear();
+		for (uint32_t i = 0; i != maxChunks; i++)
+			if (auto* chunk = chunks[i].load())
+				::operator delete(chunk, std::align_val_t(alignof(Node)));
+	}
+
+	MCTSNodePool(const MCTSNodePool&) = delete;
+	MCTSNodePool& operator=(const MCTSNodePool&) = delete;
+
+	Node& operator[](uint32_t index)
+	{
+		return chunks[index >> chunkBits].load(
+				std::memory_order_acquire)[index & (chunkSize - 1)];
+	}
+
+	// reserves count contiguous slots and returns the index of the first one.
+	// The caller must construct every reserved slot with construct before the
+	// pool is cleared.
+	uint32_t reserve(uint32_t count)
+	{
+		assert(count <= chunkSize);
+		std::lock_guard<std::mutex> lock(mutex);
+		uint32_t offset = size & (chunkSize - 1);
+		if (offset != 0 and offset + count > chunkSize)
+			size += chunkSize - offset;
+		if (size + count >= Node::none)
+		{
+			std::cerr << "MCTS: the search tree can't hold more nodes\n";
+			std::abort();
+		}
+
+		auto chunkIndex = size >> chunkBits;
+		if (chunks[chunkIndex].load(std::memory_order_relaxed) == nullptr)
+			chunks[chunkIndex].store(
+					static_cast<Node*>(::operator new(
+							sizeof(Node) * chunkSize, std::align_val_t(alignof(Node)))),
+					std::memory_order_release);
+
+		auto first = static_cast<uint32_t>(size);
+		size += count;
+		constructed[chunkIndex] = (size - 1) % chunkSize + 1;
+		return first;
+	}
+
+	template<typename... Args>
+	Node& construct(uint32_t index, Args&&... args)
+	{
+		return *new (&(*this)[index]) Node(std::forward<Args>(args)...);
+	}
+
+	// destroys every node, keeping the chunks around for the next tree
+	void clear()
 	{
-		std::cout << "\"" << this << "\"" << "[label=\"" << state.getAction()
-							<< " visits=" << visits << ", average_value=" << (reward / visits)
-							<< ", player " << state.getCurrentPlayer() << ", hash "
-							<< hash(state.getPayload()) << "\"];\n";
-		for (auto& child : children)
+		for (uint32_t i = 0; i != maxChunks and constructed[i] != 0; i++)
 		{
-			std::cout << "\"" << this << "\"" << " -> " << "\"" << child.get() << "\""
-								<< "\n";
-			child->dumpDot();
+			auto* chunk = chunks[i].load();
+			for (uint32_t j = 0; j != constructed[i]; j++)
+				chunk[j].~Node();
+			constructed[i] = 0;
 		}
+		size = 0;
 	}
+
+	private:
+	std::mutex mutex;
+	uint64_t size = 0;
+	std::unique_ptr<std::atomic<Node*>[]> chunks;
+	std::vector<uint32_t> constructed;
 };
 
-static std::map<int64_t, size_t> visitedNodeMap;
 static constexpr const float discout_factor = 1;
 
-template<typename State>
-MCTSNode<State>* MCTSNode<State>::select()
-{
-	MCTSNode* node = this;
-
-	while (!node->children.empty() and node->untriedActions.empty())
-	{
-		node = (*std::max_element(
-								node->children.begin(),
-								node->children.end(),
-								[&](const std::unique_ptr<MCTSNode>& a,
-										const std::unique_ptr<MCTSNode>& b) {
-									return ((a->reward) / double(a->visits)) +
-														 std::sqrt(
-																 2 * std::log(a->parent->visits) / a->visits) <
-												 ((b->reward) / double(b->visits)) +
-														 std::sqrt(
-																 2 * std::log(b->parent->visits) / b->visits);
-								}))
-							 .get();
-	}
-	return node;
-}
-
-template<typename State>
-void MCTSNode<State>::expand()
+// A fixed set of threads that repeatedly run the same job, so that searches
+// do not pay for spawning threads every time they are invoked.
+class MCTSWorkerPool
 {
-	if (untriedActions.empty())
+	public:
+	explicit MCTSWorkerPool(size_t size)
 	{
-		untriedActions = state.getLegalActions();
+		for (size_t i = 0; i != size; i++)
+			threads.emplace_back([this, i]() { loop(i); });
 	}
-	assert(not untriedActions.empty() or state.isTerminal());
-	State newState;
-	int64_t node_hash;
-	auto entry = visitedNodeMap.begin();
-	do
+
+	~MCTSWorkerPool()
 	{
-		if (untriedActions.empty())
-			return;
+		{
+			std::lock_guard<std::mutex> lock(mutex);
+			stopping = true;
+		}
+		wake.notify_all();
+		for (auto& thread : threads)
+			thread.join();
+	}
 
-		typename State::Action action = untriedActions.back();
-		untriedActions.pop_back();
-		newState = state;
-		newState.applyAction(action);
-		node_hash = hash(newState.getPayload());
-		entry = visitedNodeMap.find(node_hash);
+	MCTSWorkerPool(const MCTSWorkerPool&) = delete;
+	MCTSWorkerPool& operator=(const MCTSWorkerPool&) = delete;
 
-	} while (entry != visitedNodeMap.end() and entry->second < depth + 1);
-	children.push_back(std::make_unique<MCTSNode>(newState, this));
-	visitedNodeMap[node_hash] = depth + 1;
-	children.back().get()->depth = depth + 1;
-}
+	size_t size() const { return threads.size(); }
 
-template<typename State>
-void MCTSNode<State>::simulate_woker(double* result)
-{
-	std::random_device r;
-	State currentState = state;
-	std::default_random_engine generator(r());
-	size_t count = 0;
-	while (!currentState.isTerminal())
+	// invokes job(workerIndex) once on every worker and waits for all of them
+	// to return
+	void runOnAll(std::function<void(size_t)> toRun)
 	{
-		// auto node_hash = hash(state.getPayload());
-		// if (auto iter = visitedNodeMap.find(node_hash); iter !=
-		// visitedNodeMap.end()) { *result = iter->second->reward *
-		// std::pow(discout_factor, count); return;
-		//}
+		std::unique_lock<std::mutex> lock(mutex);
+		job = std::move(toRun);
+		pending = threads.size();
+		generation++;
+		wake.notify_all();
+		done.wait(lock, [this]() { return pending == 0; });
+		job = nullptr;
+	}
 
-		count++;
-		auto legalActions = currentState.getLegalActions();
-		std::uniform_int_distribution<int> distribution(0, legalActions.size() - 1);
-		currentState.applyAction(legalActions[distribution(generator)]);
-		if (count == max_game_lenght())
+	private:
+	void loop(size_t index)
+	{
+		uint64_t seen = 0;
+		while (true)
 		{
-			*result = 0;
-			return;
+			std::unique_lock<std::mutex> lock(mutex);
+			wake.wait(lock, [&]() { return stopping or generation != seen; });
+			if (stopping)
+				return;
+			seen = generation;
+			lock.unlock();
+
+			job(index);
+
+			lock.lock();
+			if (--pending == 0)
+				done.notify_one();
 		}
 	}
-	*result = currentState.getReward() * std::pow(discout_factor, count);
-}
 
-template<typename State>
-double MCTSNode<State>::simulate(uint64_t num_threads)
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable done;
+	std::function<void(size_t)> job;
+	uint64_t generation = 0;
+	size_t pending = 0;
+	bool stopping = false;
+	std::vector<std::thread> threads;
+};
+
+// The leaves of a PUCT search waiting to be evaluated together.
+template<typename Action>
+struct MCTSBatch
 {
-	if (state.isTerminal())
-		return state.getReward();
-	double to_return;
-	simulate_woker(&to_return);
-	return to_return;
+	// size() observation tensors of observationSize floats each, one after
+	// the other
+	std::vector<float> observations;
+	size_t observationSize = 0;
+	// the legal actions of each leaf, the priors returned for it must follow
+	// the same order
+	std::vector<const std::vector<Action>*> legalActions;
 
-	double results[num_threads];
-	std::thread threads[num_threads];
-	for (uint64_t i = 0; i != num_threads; i++)
+	size_t size() const { return legalActions.size(); }
+	const float* observation(size_t index) const
 	{
-		threads[i] =
-				std::thread([&results, i, this]() { simulate_woker(&results[i]); });
+		return observations.data() + index * observationSize;
 	}
+};
 
-	for (uint64_t i = 0; i != num_threads; i++)
+struct MCTSEvaluation
+{
+	// one for each legal action, uniform if left empty
+	std::vector<float> priors;
+	// the expected reward of the state for player zero, like
+	// GameState::getReward
+	double value = 0;
+};
+
+// fills out with a evaluation for each leaf of the batch. It is never invoked
+// concurrently, so it can be a single model running on the cpu, as well as a
+// stub.
+template<typename Action>
+using MCTSEvaluator =
+		std::function<void(const MCTSBatch<Action>&, std::vector<MCTSEvaluation>&)>;
+
+// a evaluator that knows nothing about the game: every legal action is
+// equally likely and every state is a draw. Useful to test a PUCT search
+// before a model is available.
+template<typename Action>
+void uniformEvaluator(
+		const MCTSBatch<Action>& batch, std::vector<MCTSEvaluation>& out)
+{
+	for (size_t i = 0; i != batch.size(); i++)
 	{
-		threads[i].join();
+		auto count = batch.legalActions[i]->size();
+		out[i].priors.assign(count, count == 0 ? 0.0f : 1.0f / count);
+		out[i].value = 0;
 	}
-
-	return std::accumulate(results, results + num_threads, 0.0) / num_threads;
 }
 
-template<typename State>
-void MCTSNode<State>::backpropagate(double reward)
+// Collects the leaves reached by the threads of a PUCT search and sends them
+// to the evaluator in batches. A batch is evaluated as soon as it holds
+// batchSize leaves, or when every thread still searching is waiting for it,
+// or when a thread can't make progress until it is evaluated.
+template<typename Action>
+class MCTSEvaluationQueue
 {
-	MCTSNode* node = this;
-	while (node)
+	public:
+	MCTSEvaluationQueue(MCTSEvaluator<Action> evaluator, size_t batchSize)
+			: evaluator(std::move(evaluator)),
+				batchSize(std::max<size_t>(1, batchSize))
 	{
-		node->visits++;
-		int choiseMaker =
-				node->parent == nullptr ? 0 : node->parent->state.getCurrentPlayer();
-		if (1 == choiseMaker)
-			node->reward -= reward;
-		// node->reward += reward;
-		else
-			// node->reward -= reward;
-			node->reward += reward;
-		node = node->parent;
-		reward = reward * discout_factor;
 	}
-}
+
+	// invoked before a search, with the number of threads taking part to it
+	void start(size_t workers)
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		activeWorkers = workers;
+	}
+
+	// invoked by each thread when it stops searching
+	void leave()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		activeWorkers--;
+		if (not pending.empty() and pending.size() >= activeWorkers)
+			runBatch(lock);
+	}
+
+	// blocks until the leaf has been evaluated, possibly evaluating the leaves
+	// submitted by other threads too
+	void evaluate(
+			const std::vector<float>& observation,
+			const std::vector<Action>& legalActions,
+			MCTSEvaluation& result)
+	{
+		bool done = false;
+		std::unique_lock<std::mutex> lock(mutex);
+		pending.push_back(Request{ &observation, &legalActions, &result, &done });
+		if (pending.size() >= batchSize or pending.size() >= activeWorkers)
+			runBatch(lock);
+		evaluated.wait(lock, [&]() { return done; });
+	}
+
+	// invoked by threads that can't submit a leaf, so that the ones already
+	// waiting are not blocked by them
+	void flush()
+	{
+		std::unique_lock<std::mutex> lock(mutex);
+		if (not pending.empty())
+			runBatch(lock);
+	}
+
+	private:
+	struct Request
+	{
+		const std::vector<float>* observation;
+		const std::vector<Action>* legalActions;
+		MCTSEvaluation* result;
+		bool* done;
+	};
+
+	void runBatch(std::unique_lock<std::mutex>& lock)
+	{
+		std::vector<Request> requests;
+		requests.swap(pending);
+		lock.unlock();
+
+		std::vector<MCTSEvaluation> results(requests.size());
+		{
+			std::lock_guard<std::mutex> evaluating(evaluatorMutex);
+			batch.observationSize = requests.front().observation->size();
+			batch.observations.clear();
+			batch.legalActions.clear();
+			for (auto& request : requests)
+			{
+				batch.observations.insert(
+						batch.observations.end(),
+						request.observation->begin(),
+						request.observation->end());
+				batch.legalActions.push_back(request.legalActions);
+			}
+			evaluator(batch, results);
+		}
+
+		lock.lock();
+		for (size_t i = 0; i != requests.size(); i++)
+		{
+			*requests[i].result = std::move(results[i]);
+			*requests[i].done = true;
+		}
+		evaluated.notify_all();
+	}
+
+	MCTSEvaluator<Action> evaluator;
+	size_t batchSize;
+	std::mutex mutex;
+	std::condition_variable evaluated;
+	std::vector<Request> pending;
+	size_t activeWorkers = 0;
+	std::mutex evaluatorMutex;
+	MCTSBatch<Action> batch;
+};
 
 // MCTS Algorithm
-template<typename State>
+//
+// When StoreStates is false nodes do not hold a copy of the game, which is
+// rebuilt on demand by replaying the actions from the root. This trades some
+// time for a tree that is a fraction of the size.
+//
+// By default leaves are valued with random rollouts and children are
+// selected with UCT. Once a evaluator is set the search switches to PUCT:
+// leaves are valued by the evaluator, in batches gathered across threads,
+// and the priors it returns steer the selection of their children.
+template<typename State, bool StoreStates = true>
 class MCTS
 {
 	public:
-	typename State::Action search(int iterations, uint64_t num_threads);
+	using Node = MCTSNode<State, StoreStates>;
+	static constexpr uint32_t root = 0;
+
+	// the transposition table outlives setState, so what is learned while
+	// searching a move is reused by the searches of the following ones.
+	explicit MCTS(size_t transpositionTableEntries = 1 << 20)
+			: table(transpositionTableEntries)
+	{
+	}
+
+	// switches the search to PUCT, see MCTSEvaluationQueue
+	void setEvaluator(
+			MCTSEvaluator<typename State::Action> evaluator,
+			size_t batchSize,
+			double exploration = 1.5)
+	{
+		evaluations = std::make_unique<MCTSEvaluationQueue<typename State::Action>>(
+				std::move(evaluator), batchSize);
+		puctExploration = exploration;
+	}
+
+	// runs simulations on num_threads threads until the root has been visited
+	// iterations times, zero threads means one per core.
+	typename State::Action search(int iterations, uint64_t num_threads = 0);
 	void promoteBest();
 	void promoteNth(int64_t action);
 	void promoteRandom();
-	std::unique_ptr<MCTSNode<State>>& getBestNode();
+	uint32_t getBestNode();
 	void setState(const State& initialState);
-	const State& getState() const { return (*root).state; }
+	const State& getState() const { return rootState; }
+	Node& getNode(uint32_t index) { return nodes[index]; }
+	State stateOf(uint32_t index);
 
 	private:
-	std::unique_ptr<MCTSNode<State>> root;
-	void worker(MCTSNode<State>* node, uint64_t num_threads);
+	State rootState;
+	MCTSNodePool<Node> nodes;
+	MCTSTranspositionTable table;
+	std::unique_ptr<MCTSWorkerPool> pool;
+	std::vector<std::default_random_engine> generators;
+	std::unique_ptr<MCTSEvaluationQueue<typename State::Action>> evaluations;
+	double puctExploration = 1.5;
+	uint32_t select();
+	bool claim(uint32_t index);
+	void expand(
+			uint32_t index,
+			const State& state,
+			const std::vector<typename State::Action>& legalActions,
+			const std::vector<float>* priors);
+	double simulate(State state, std::default_random_engine& generator);
+	void backpropagate(uint32_t index, double reward);
+	void revertVirtualLoss(uint32_t index);
+	void rolloutWorker(std::default_random_engine& generator);
+	bool evaluationWorker();
+	void ensureWorkers(uint64_t num_threads);
 
 	public:
 	void dumpDot()
 	{
 		std::cout << "digraph g {\n";
-		root->dumpDot();
+		dumpDot(root);
 		std::cout << "}\n";
 	}
+
+	private:
+	void dumpDot(uint32_t index)
+	{
+		auto& node = nodes[index];
+		std::cout << "\"" << index << "\"" << "[label=\"" << node.action
+							<< " visits=" << node.visits.load() << ", average_value="
+							<< (node.reward.load() / node.visits.load()) << ", player "
+							<< node.player << ", hash " << node.stateHash << "\"];\n";
+		if (not node.isExpanded())
+			return;
+		for (uint32_t i = 0; i != node.childCount; i++)
+		{
+			std::cout << "\"" << index << "\"" << " -> " << "\""
+								<< node.firstChild + i << "\"" << "\n";
+			dumpDot(node.firstChild + i);
+		}
+	}
 };
 
-template<typename State>
-void MCTS<State>::worker(MCTSNode<State>* node, uint64_t num_threads)
+template<typename State, bool StoreStates>
+State MCTS<State, StoreStates>::stateOf(uint32_t index)
+{
+	if constexpr (StoreStates)
+	{
+		return nodes[index].state;
+	}
+	else
+	{
+		static thread_local std::vector<typename State::Action> path;
+		path.clear();
+		for (; index != root; index = nodes[index].parent)
+			path.push_back(nodes[index].action);
+		State state = rootState;
+		for (auto action = path.rbegin(); action != path.rend(); action++)
+			state.applyAction(*action);
+		return state;
+	}
+}
+
+template<typename State, bool StoreStates>
+uint32_t MCTS<State, StoreStates>::select()
+{
+	uint32_t index = root;
+	nodes[index].virtualLoss.fetch_add(1, std::memory_order_relaxed);
+
+	while (nodes[index].isExpanded() and nodes[index].childCount != 0)
+	{
+		auto& node = nodes[index];
+		double parentVisits = node.visits.load(std::memory_order_relaxed) +
+													node.virtualLoss.load(std::memory_order_relaxed);
+		double logVisits = std::log(parentVisits);
+		double sqrtVisits = std::sqrt(parentVisits);
+		auto score = [&](uint32_t child) {
+			return evaluations ? nodes[child].puct(sqrtVisits, puctExploration)
+												 : nodes[child].uct(logVisits);
+		};
+		uint32_t best = node.firstChild;
+		double bestValue = score(best);
+		for (uint32_t child = best + 1; child != node.firstChild + node.childCount;
+				 child++)
+		{
+			double value = score(child);
+			if (value > bestValue)
+			{
+				best = child;
+				bestValue = value;
+			}
+		}
+		index = best;
+		nodes[index].virtualLoss.fetch_add(1, std::memory_order_relaxed);
+	}
+	return index;
+}
+
+// reserves the right of expanding the node to the calling thread, returns
+// false if another thread got to it first.
+template<typename State, bool StoreStates>
+bool MCTS<State, StoreStates>::claim(uint32_t index)
+{
+	auto expected = Node::Expansion::unexpanded;
+	return nodes[index].expansion.compare_exchange_strong(
+			expected, Node::Expansion::expanding, std::memory_order_acquire);
+}
+
+// expands a claimed node with a child for each legal action, except those
+// leading to states already reached at a lower depth. Children start with the
+// statistics the transposition table holds about their state, and with the
+// given priors, if any.
+template<typename State, bool StoreStates>
+void MCTS<State, StoreStates>::expand(
+		uint32_t index,
+		const State& state,
+		const std::vector<typename State::Action>& legalActions,
+		const std::vector<float>* priors)
+{
+	auto& node = nodes[index];
+	struct Child
+	{
+		typename State::Action action;
+		int64_t stateHash;
+		int64_t player;
+		float prior;
+		MCTSTranspositionTable::Stats known;
+		std::conditional_t<StoreStates, State, typename Node::NoState> state;
+	};
+	static thread_local std::vector<Child> children;
+	children.clear();
+
+	assert(not legalActions.empty() or state.isTerminal());
+	for (size_t i = 0; i != legalActions.size(); i++)
+	{
+		auto action = legalActions[i];
+		State newState = state;
+		newState.applyAction(action);
+		int64_t childHash = hash(newState.getPayload());
+		auto known = table.reach(childHash, node.depth + 1);
+		if (not known)
+			continue;
+		auto player = newState.getCurrentPlayer();
+		float prior = priors and i < priors->size()
+											? (*priors)[i]
+											: 1.0f / legalActions.size();
+		if constexpr (StoreStates)
+			children.push_back(Child{
+					action, childHash, player, prior, *known, std::move(newState) });
+		else
+			children.push_back(
+					Child{ action, childHash, player, prior, *known, {} });
+	}
+
+	if (not children.empty())
+	{
+		double sign = node.player == 1 ? -1 : 1;
+		uint32_t first = nodes.reserve(static_cast<uint32_t>(children.size()));
+		for (uint32_t i = 0; i != children.size(); i++)
+		{
+			auto& child = children[i];
+			auto& created = [&]() -> Node& {
+				if constexpr (StoreStates)
+					return nodes.construct(
+							first + i,
+							index,
+							child.action,
+							node.depth + 1,
+							child.stateHash,
+							child.player,
+							std::move(child.state));
+				else
+					return nodes.construct(
+							first + i,
+							index,
+							child.action,
+							node.depth + 1,
+							child.stateHash,
+							child.player);
+			}();
+			created.prior = child.prior;
+			created.visits.store(child.known.visits, std::memory_order_relaxed);
+			created.reward.store(
+					sign * child.known.reward, std::memory_order_relaxed);
+		}
+		node.firstChild = first;
+		node.childCount = static_cast<uint32_t>(children.size());
+	}
+
+	node.expansion.store(Node::Expansion::expanded, std::memory_order_release);
+}
+
+template<typename State, bool StoreStates>
+double MCTS<State, StoreStates>::simulate(
+		State state, std::default_random_engine& generator)
+{
+	int64_t count = 0;
+	while (!state.isTerminal())
+	{
+		count++;
+		auto legalActions = state.getLegalActions();
+		std::uniform_int_distribution<int> distribution(0, legalActions.size() - 1);
+		state.applyAction(legalActions[distribution(generator)]);
+		if (count == max_game_lenght())
+			return 0;
+	}
+	return state.getReward() * std::pow(discout_factor, count);
+}
+
+template<typename State, bool StoreStates>
+void MCTS<State, StoreStates>::backpropagate(uint32_t index, double reward)
+{
+	for (; index != Node::none; index = nodes[index].parent)
+	{
+		auto& node = nodes[index];
+		table.update(node.stateHash, reward);
+		node.visits.fetch_add(1, std::memory_order_relaxed);
+		node.virtualLoss.fetch_sub(1, std::memory_order_relaxed);
+		int64_t choiseMaker =
+				node.parent == Node::none ? 0 : nodes[node.parent].player;
+		if (1 == choiseMaker)
+			atomicAdd(node.reward, -reward);
+		else
+			atomicAdd(node.reward, reward);
+		reward = reward * discout_factor;
+	}
+}
+
+template<typename State, bool StoreStates>
+void MCTS<State, StoreStates>::revertVirtualLoss(uint32_t index)
+{
+	for (; index != Node::none; index = nodes[index].parent)
+		nodes[index].virtualLoss.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template<typename State, bool StoreStates>
+void MCTS<State, StoreStates>::rolloutWorker(
+		std::default_random_engine& generator)
 {
-	MCTSNode<State>* selectedNode = node->select();
-	if (!selectedNode->state.isTerminal())
+	uint32_t selected = select();
+	State state = stateOf(selected);
+	if (!state.isTerminal() and claim(selected))
 	{
-		selectedNode->expand();
-		if (not selectedNode->children.empty())
+		expand(selected, state, state.getLegalActions(), nullptr);
+		if (nodes[selected].childCount != 0)
 		{
-			selectedNode = selectedNode->children.back().get();
+			auto& node = nodes[selected];
+			std::uniform_int_distribution<uint32_t> distribution(
+					0, node.childCount - 1);
+			selected = node.firstChild + distribution(generator);
+			nodes[selected].virtualLoss.fetch_add(1, std::memory_order_relaxed);
+			state.applyAction(nodes[selected].action);
 		}
 	}
-	double reward = selectedNode->simulate(num_threads);
-	selectedNode->backpropagate(reward);
+	double reward = simulate(std::move(state), generator);
+	backpropagate(selected, reward);
+}
+
+// values the selected leaf with the evaluator instead of a rollout, returns
+// false if the leaf is being evaluated by another thread already, in which
+// case nothing has been learned.
+template<typename State, bool StoreStates>
+bool MCTS<State, StoreStates>::evaluationWorker()
+{
+	uint32_t selected = select();
+	State state = stateOf(selected);
+	if (state.isTerminal())
+	{
+		backpropagate(selected, state.getReward());
+		return true;
+	}
+
+	bool expanding = claim(selected);
+	if (not expanding and not nodes[selected].isExpanded())
+	{
+		revertVirtualLoss(selected);
+		evaluations->flush();
+		std::this_thread::yield();
+		return false;
+	}
+
+	static thread_local std::vector<float> observation;
+	observation.resize(state.observationSize());
+	state.writeObservation(observation.data());
+	auto legalActions = state.getLegalActions();
+	MCTSEvaluation evaluation;
+	evaluations->evaluate(observation, legalActions, evaluation);
+
+	if (expanding)
+		expand(selected, state, legalActions, &evaluation.priors);
+	backpropagate(selected, evaluation.value);
+	return true;
+}
+
+template<typename State, bool StoreStates>
+void MCTS<State, StoreStates>::ensureWorkers(uint64_t num_threads)
+{
+	if (generators.size() != num_threads)
+	{
+		std::random_device r;
+		generators.clear();
+		for (uint64_t i = 0; i != num_threads; i++)
+			generators.emplace_back(r());
+	}
+	if (num_threads > 1 and (pool == nullptr or pool->size() != num_threads))
+		pool = std::make_unique<MCTSWorkerPool>(num_threads);
 }
 
-template<typename State>
-void MCTS<State>::setState(const State& initialState)
+template<typename State, bool StoreStates>
+void MCTS<State, StoreStates>::setState(const State& initialState)
 {
-	root = std::make_unique<MCTSNode<State>>(initialState);
-	visitedNodeMap.clear();
+	nodes.clear();
+	rootState = initialState;
+	int64_t stateHash = hash(rootState.getPayload());
+	auto index = nodes.reserve(1);
+	if constexpr (StoreStates)
+		nodes.construct(
+				index,
+				Node::none,
+				rootState.getAction(),
+				0,
+				stateHash,
+				rootState.getCurrentPlayer(),
+				rootState);
+	else
+		nodes.construct(
+				index,
+				Node::none,
+				rootState.getAction(),
+				0,
+				stateHash,
+				rootState.getCurrentPlayer());
+	table.newGeneration();
+	table.reach(stateHash, 0);
 }
 
-template<typename State>
-std::unique_ptr<MCTSNode<State>>& MCTS<State>::getBestNode()
+template<typename State, bool StoreStates>
+uint32_t MCTS<State, StoreStates>::getBestNode()
 {
 	// if (root->state.getObserver() == root->state.getCurrentPlayer())
-	return (*std::max_element(
-			root->children.begin(),
-			root->children.end(),
-			[](const std::unique_ptr<MCTSNode<State>>& a,
-				 const std::unique_ptr<MCTSNode<State>>& b) {
-				return a->visits < b->visits;
-			}));
+	auto& node = nodes[root];
+	assert(node.isExpanded() and node.childCount != 0);
+	uint32_t best = node.firstChild;
+	for (uint32_t child = best + 1; child != node.firstChild + node.childCount;
+			 child++)
+		if (nodes[child].visits.load() > nodes[best].visits.load())
+			best = child;
+	return best;
 }
 
-template<typename State>
-void MCTS<State>::promoteBest()
+template<typename State, bool StoreStates>
+void MCTS<State, StoreStates>::promoteBest()
 {
-	// auto best = std::move();
-	setState(getBestNode()->state);
-	// root = std::move(best);
-	//(*root).parent = nullptr;
+	setState(stateOf(getBestNode()));
 }
 
-template<typename State>
-void MCTS<State>::promoteNth(int64_t action)
+template<typename State, bool StoreStates>
+void MCTS<State, StoreStates>::promoteNth(int64_t action)
 {
 	auto state = getState();
 	state.applyAction(action);
@@ -338,26 +1120,58 @@ void MCTS<State>::promoteNth(int64_t action)
 	return;
 }
 
-template<typename State>
-void MCTS<State>::promoteRandom()
+template<typename State, bool StoreStates>
+void MCTS<State, StoreStates>::promoteRandom()
 {
 	std::random_device r;
 	std::default_random_engine generator(r());
-	std::uniform_int_distribution<int> distribution(0, root->children.size() - 1);
-	auto best = std::move(root->children[distribution(generator)]);
-	root = std::move(best);
-	(*root).parent = nullptr;
+	auto& node = nodes[root];
+	std::uniform_int_distribution<uint32_t> distribution(
+			0, node.childCount - 1);
+	setState(stateOf(node.firstChild + distribution(generator)));
 }
 
-template<typename State>
-typename State::Action MCTS<State>::search(int iterations, uint64_t num_threads)
+template<typename State, bool StoreStates>
+typename State::Action MCTS<State, StoreStates>::search(
+		int iterations, uint64_t num_threads)
 {
-	while (root->visits < iterations)
-	{
-		worker(root.get(), num_threads);
-	}
+	if (num_threads == 0)
+		num_threads = std::max(1u, std::thread::hardware_concurrency());
+	ensureWorkers(num_threads);
+
+	// every thread claims simulations from a shared budget, so that the root
+	// is visited iterations times. Evaluations that could not take place are
+	// given back. The budget never goes below zero, otherwise what is given
+	// back after the other threads overdrew it would be lost.
+	std::atomic<int64_t> budget = iterations - nodes[root].visits.load();
+	auto claimSimulation = [&]() {
+		int64_t left = budget.load(std::memory_order_relaxed);
+		while (left > 0)
+			if (budget.compare_exchange_weak(
+							left, left - 1, std::memory_order_relaxed))
+				return true;
+		return false;
+	};
+	if (evaluations)
+		evaluations->start(num_threads);
+	auto run = [&](size_t index) {
+		while (claimSimulation())
+		{
+			if (not evaluations)
+				rolloutWorker(generators[index]);
+			else if (not evaluationWorker())
+				budget.fetch_add(1, std::memory_order_relaxed);
+		}
+		if (evaluations)
+			evaluations->leave();
+	};
+
+	if (num_threads == 1)
+		run(0);
+	else
+		pool->runOnAll(run);
 
-	return getBestNode()->state.getAction();
+	return nodes[getBestNode()].action;
 }
 
 bool playGame(size_t iterations, size_t iterations2)
@@ -386,14 +1200,14 @@ bool playGame(size_t iterations, size_t iterations2)
 		int64_t bestAction;
 		if (mcts.getState().getCurrentPlayer() == 1)
 		{
-			mcts.search(iterations2, 16);
+			mcts.search(iterations2);
 			// std::cout << "random\n";
 			// mcts.promoteRandom();
 			mcts.promoteBest();
 		}
 		else
 		{
-			mcts.search(iterations, 16);
+			mcts.search(iterations);
 			mcts.promoteBest();
 			//
 			// auto acts = mcts.getState().getLegalActions();
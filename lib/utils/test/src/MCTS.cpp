@@ -0,0 +1,132 @@
+/*
+Copyright 2024 Massimo Fioravanti
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+   http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+*/
+#define RLC_GET_FUNCTION_DECLS
+#define RLC_GET_TYPE_DECLS
+#define RLC_GET_TYPE_DEFS
+#include <cstdint>
+
+// the header rlc emits for tool/rlc/test/nim.rl, that MCTS.hpp is written
+// against
+#include "Nim.h"
+#include "gtest/gtest.h"
+#include "rlc/utils/MCTS.hpp"
+
+static constexpr size_t tableEntries = 1 << 12;
+
+// checks that every node of the tree agrees with the state it is reached by,
+// and that no virtual loss is left behind by the threads of the search
+template<bool StoreStates>
+static void checkTree(MCTS<GameState, StoreStates>& mcts, uint32_t index)
+{
+	auto& node = mcts.getNode(index);
+	EXPECT_EQ(node.virtualLoss.load(), 0);
+	EXPECT_EQ(hash(mcts.stateOf(index).getPayload()), node.stateHash);
+	if (not node.isExpanded())
+		return;
+
+	for (uint32_t child = node.firstChild;
+			 child != node.firstChild + node.childCount;
+			 child++)
+	{
+		EXPECT_EQ(mcts.getNode(child).parent, index);
+		EXPECT_EQ(mcts.getNode(child).depth, node.depth + 1);
+		checkTree(mcts, child);
+	}
+}
+
+// applies the action the search picked to the initial state and returns how
+// many stones are left, four if it picked the winning move
+static int64_t stonesLeftBy(int64_t action)
+{
+	GameState state;
+	state.applyAction(action);
+	return remaining_stones(state.getPayload());
+}
+
+TEST(MCTSTest, multiThreadedSearchShouldFindTheWinningMove)
+{
+	MCTS<GameState> mcts(tableEntries);
+	mcts.setState(GameState());
+	auto action = mcts.search(20000, 4);
+
+	EXPECT_EQ(stonesLeftBy(action), 4);
+	EXPECT_EQ(mcts.getNode(MCTS<GameState>::root).visits.load(), 20000);
+	checkTree(mcts, MCTS<GameState>::root);
+}
+
+TEST(MCTSTest, multiThreadedSearchShouldWinAsFirstPlayer)
+{
+	MCTS<GameState> mcts(tableEntries);
+	mcts.setState(GameState());
+	while (not mcts.getState().isTerminal())
+	{
+		mcts.search(5000, 4);
+		mcts.promoteBest();
+	}
+	EXPECT_EQ(mcts.getState().getReward(), 1.0);
+}
+
+TEST(MCTSTest, searchWithoutStatesShouldRebuildThemFromTheRoot)
+{
+	MCTS<GameState, false> mcts(tableEntries);
+	mcts.setState(GameState());
+	auto action = mcts.search(20000, 4);
+
+	EXPECT_EQ(stonesLeftBy(action), 4);
+	EXPECT_EQ(mcts.getNode(MCTS<GameState, false>::root).visits.load(), 20000);
+	checkTree(mcts, MCTS<GameState, false>::root);
+}
+
+TEST(MCTSTest, puctSearchShouldEvaluateLeavesInBatches)
+{
+	constexpr size_t batchSize = 8;
+	size_t batches = 0;
+	size_t evaluatedLeaves = 0;
+	bool wellFormed = true;
+	auto evaluator = [&](const MCTSBatch<int64_t>& batch,
+											 std::vector<MCTSEvaluation>& out) {
+		// never invoked concurrently, so no synchronization is needed
+		batches++;
+		evaluatedLeaves += batch.size();
+		wellFormed = wellFormed and batch.size() <= batchSize and
+								 out.size() == batch.size() and
+								 batch.observations.size() ==
+										 batch.size() * batch.observationSize;
+		uniformEvaluator(batch, out);
+	};
+
+	MCTS<GameState> mcts(tableEntries);
+	mcts.setEvaluator(evaluator, batchSize);
+	mcts.setState(GameState());
+	mcts.search(2000, 4);
+
+	EXPECT_NE(batches, 0u);
+	EXPECT_LE(evaluatedLeaves, 2000u);
+	EXPECT_TRUE(wellFormed);
+	EXPECT_EQ(mcts.getNode(MCTS<GameState>::root).visits.load(), 2000);
+	checkTree(mcts, MCTS<GameState>::root);
+}
+
+TEST(MCTSTest, puctSearchWithoutStatesShouldEvaluateLeaves)
+{
+	MCTS<GameState, false> mcts(tableEntries);
+	mcts.setEvaluator(uniformEvaluator<int64_t>, 4);
+	mcts.setState(GameState());
+	mcts.search(2000, 4);
+
+	EXPECT_EQ(mcts.getNode(MCTS<GameState, false>::root).visits.load(), 2000);
+	checkTree(mcts, MCTS<GameState, false>::root);
+}
@@ -154,11 +154,24 @@ endMacro(rlcAddBenchmark)
 ##############################
 function(rlcRuntime target)
 set (RUNTIME_LIB ${CMAKE_CURRENT_BINARY_DIR}/lib${target}${CMAKE_STATIC_LIBRARY_SUFFIX})
+# 1. The bitcode sits next to the archive, rlc links it into optimized
+# programs so that the runtime functions can be inlined in them. rlc can only
+# read the bitcode written by the LLVM it is built against, so it is emitted by
+# the clang of that LLVM rather than by the C compiler.
+set (RUNTIME_OUTPUTS ${RUNTIME_LIB})
+set (RUNTIME_BITCODE_COMMAND)
+find_program(RLC_RUNTIME_BITCODE_CLANG clang HINTS ${LLVM_TOOLS_BINARY_DIR} NO_DEFAULT_PATH)
+if (RLC_RUNTIME_BITCODE_CLANG)
+  set (RUNTIME_BITCODE ${CMAKE_CURRENT_BINARY_DIR}/lib${target}.bc)
+  list(APPEND RUNTIME_OUTPUTS ${RUNTIME_BITCODE})
+  set (RUNTIME_BITCODE_COMMAND COMMAND ${RLC_RUNTIME_BITCODE_CLANG} -std=c11 -O3 -c -emit-llvm ${ARGN} -o ${RUNTIME_BITCODE} -I ${CMAKE_CURRENT_SOURCE_DIR}/include)
+endif()
 # 2. Custom build rule – you decide exactly how clang is invoked
 add_custom_command(
-    OUTPUT ${RUNTIME_LIB}
+    OUTPUT ${RUNTIME_OUTPUTS}
     # compile
     COMMAND ${CMAKE_C_COMPILER} -std=c11 -O3 -c ${ARGN} -o ${target}.o -I ${CMAKE_CURRENT_SOURCE_DIR}/include
+    ${RUNTIME_BITCODE_COMMAND}
     # archive
     COMMAND ${CMAKE_AR} rcs ${RUNTIME_LIB} ${target}.o
     DEPENDS ${RUNTIME_SRC}
@@ -184,7 +197,7 @@ set_target_properties(rlc_${target}_runtime PROPERTIES
 add_dependencies(rlc_${target}_runtime build_rlc_${target}_runtime)
 
 # 5. Install like any other normal target
-install(FILES ${RUNTIME_LIB}
+install(FILES ${RUNTIME_OUTPUTS}
         DESTINATION ${CMAKE_INSTALL_LIBDIR})
 
 install(DIRECTORY ${CMAKE_CURRENT_SOURCE_DIR}/include/
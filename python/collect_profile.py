@@ -0,0 +1,114 @@
+#
+# This file is part of the RLC project.
+#
+# RLC is free software: you can redistribute it and/or modify it under the terms of the GNU General Public License version 2 as published by the Free Software Foundation.
+#
+# RLC is distributed in the hope that it will be useful, but WITHOUT ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along with RLC. If not, see <https://www.gnu.org/licenses/>.
+#
+import os
+import random
+import subprocess
+import sys
+from shutil import which
+from tempfile import mkdtemp
+from rlc import compile
+from command_line import make_rlc_argparse
+
+
+def read_games(path):
+    # traces are written by play.py: a "# game: N" line starts every game,
+    # followed by one action per line.
+    games = [[]]
+    with open(path) as file:
+        for line in file:
+            line = line.strip()
+            if line.startswith("# game:") and len(games[-1]) != 0:
+                games.append([])
+            if line == "" or line.startswith("#"):
+                continue
+            games[-1].append(line)
+    return [game for game in games if len(game) != 0]
+
+
+def replay(program, game):
+    state = program.start()
+    for text in game:
+        action = program.parse_action(text)
+        assert action is not None, f"could not parse action {text}"
+        state.step(action)
+
+
+def random_playout(program, max_steps):
+    state = program.start()
+    for _ in range(max_steps):
+        if state.is_done():
+            return
+        legal_actions = state.legal_actions
+        if len(legal_actions) == 0:
+            return
+        state.step(random.choice(legal_actions))
+
+
+def main():
+    parser = make_rlc_argparse(
+        "collect_profile",
+        description="compiles the rulebook with --pgo-gen, replays recorded games and plays random ones, and writes the resulting profile, to be passed to rlc --pgo-use",
+    )
+    parser.add_argument(
+        "--traces",
+        type=str,
+        nargs="*",
+        help="games recorded by play.py to replay",
+        default=[],
+    )
+    parser.add_argument("--playouts", type=int, default=100)
+    parser.add_argument("--max-steps", type=int, default=1000)
+    parser.add_argument("--seed", type=int, default=0)
+    parser.add_argument("--llvm-profdata", type=str, default="llvm-profdata")
+    parser.add_argument(
+        "--output",
+        "-o",
+        type=str,
+        nargs="?",
+        help="path where to write the profile",
+        default="default.profdata",
+    )
+
+    args = parser.parse_args()
+    assert (
+        which(args.llvm_profdata) is not None
+    ), "could not find executable {}, use --llvm-profdata <path> to configure it".format(
+        args.llvm_profdata
+    )
+    random.seed(args.seed)
+
+    raw_profile = os.path.join(mkdtemp(), "rulebook.profraw")
+    with compile(
+        [args.source_file],
+        args.rlc,
+        [include for include in args.include],
+        args.runtime,
+        optimized=True,
+        stdlib=args.stdlib,
+        pyrlc_runtime_lib=args.pyrlc,
+        pgo_gen=raw_profile,
+    ) as program:
+        for trace in args.traces:
+            for game in read_games(trace):
+                replay(program, game)
+        for _ in range(args.playouts):
+            random_playout(program, args.max_steps)
+        # the profile is written when the process exits too, but it must be
+        # on disk before it is merged
+        assert getattr(program.module.lib, "__llvm_profile_write_file")() == 0
+
+    result = subprocess.run(
+        [args.llvm_profdata, "merge", "-o", args.output, raw_profile]
+    )
+    sys.exit(result.returncode)
+
+
+if __name__ == "__main__":
+    main()
@@ -100,11 +100,20 @@ class SingleRLCEnvironment:
             else self.module.rl_score__Game_int64_t_r_double
         )
         self.num_actions = len(self.state.actions)
+        # the tensor layout is fixed at compile time,
+        # so its size is computed only once
+        self.state_size = (
+            self.module.observation_tensor_size(self.module.Game()) + 1
+        )
         self.serialized = self.module.VectorTdoubleT()
         self.serialized.resize(self.get_state_size())
         self.serialized_player_id = self.serialized.get(self.get_state_size() - 1)
-        self.to_observation_tensor = (
-            self.module.rl_to_observation_tensor__Game_int64_t_VectorTdoubleT
+        # programs compiled with --incremental-observation
+        # rewrite only the fields changed since the last call
+        self.to_observation_tensor = getattr(
+            self.module,
+            "rl_update_observation_tensor__Game_int64_t_VectorTdoubleT",
+            self.module.rl_to_observation_tensor__Game_int64_t_VectorTdoubleT,
         )
         self.get_valid_actions = (
             self.module.rl_get_valid_actions__VectorTint8_tT_VectorTAnyGameActionT_Game
@@ -185,6 +194,9 @@ class SingleRLCEnvironment:
         self.current_random_index = (self.current_random_index + 1) % 1_000_000
         return to_return
 
+    def bind_state_storage(self, storage):
+        self.state.bind_storage(storage)
+
     def get_action_mask(self):
         self.get_valid_actions(
             self.valid_action_vector, self.state.raw_actions, self.state.state
@@ -256,7 +268,7 @@ class SingleRLCEnvironment:
         return self.num_actions
 
     def get_state_size(self):
-        return self.module.observation_tensor_size(self.module.Game()) + 1
+        return self.state_size
 
     def get_state(self):
         self.to_observation_tensor(self.state.state, 0, self.serialized)
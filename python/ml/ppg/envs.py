@@ -29,14 +29,61 @@ class RLCMultiEnv(Env):
             (self.num, len(self.get_user_defined_log_functions())), dtype=np.float32
         )
         self.num_actions = self.games[0].num_actions
+        self._bind_states_to_batch()
 
         super().__init__(ob_space=self.ob_space, ac_space=self.ac_space, num=self.num)
 
     def get_num_players(self):
         return self.games[0].num_players
 
+    # moves the state of every game into a single rlc vector, so that
+    # the masks of all games can be computed with one native call.
+    def _bind_states_to_batch(self):
+        module = self.games[0].module
+        self.get_valid_actions_batch = (
+            module.rl_get_valid_actions_batch__VectorTGameT_VectorTAnyGameActionT_VectorTint8_tT
+        )
+        self.batched_states = module.VectorTGameT()
+        self.batched_states.resize(self.num)
+        for i, game in enumerate(self.games):
+            game.bind_state_storage(self.batched_states.get(i).contents)
+
+        self.batched_valid_actions = module.VectorTint8_tT()
+        self.get_valid_actions_batch(
+            self.batched_states,
+            self.games[0].state.raw_actions,
+            self.batched_valid_actions,
+        )
+        self.batched_valid_actions_view = np.ctypeslib.as_array(
+            self.batched_valid_actions.get(0), shape=(self.num, self.num_actions)
+        )
+
+        # observations are written as float32 rows, one per game, padded
+        # with zeros up to the state size of the environments
+        self.write_observations = (
+            module.rl_write_observations__VectorTGameT_int64_t_int64_t_VectorTint8_tT
+        )
+        self.state_size = self.games[0].get_state_size()
+        self.batched_observations = module.VectorTint8_tT()
+        self.write_observations(
+            self.batched_states, 0, self.state_size, self.batched_observations
+        )
+        self.batched_observations_view = (
+            np.ctypeslib.as_array(
+                self.batched_observations.get(0),
+                shape=(self.num * self.state_size * 4,),
+            )
+            .view(np.float32)
+            .reshape(self.num, self.state_size, 1, 1)
+        )
+
     def action_mask(self):
-        return np.array([g.get_action_mask() for g in self.games])
+        self.get_valid_actions_batch(
+            self.batched_states,
+            self.games[0].state.raw_actions,
+            self.batched_valid_actions,
+        )
+        return self.batched_valid_actions_view.copy()
 
     def one_action_mask(self, game_id):
         return np.array([self.games[game_id].get_action_mask()])
@@ -51,8 +98,10 @@ class RLCMultiEnv(Env):
         return self.just_acted_players
 
     def observe(self):
-        obs = np.array([g.get_state() for g in self.games])
-        return self.rew, obs, self.first_move
+        self.write_observations(
+            self.batched_states, 0, self.state_size, self.batched_observations
+        )
+        return self.rew, self.batched_observations_view.copy(), self.first_move
 
     def observe_one(self, game_index):
         obs = np.array([self.games[game_index].get_state()])
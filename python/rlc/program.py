@@ -26,6 +26,7 @@ from collections import defaultdict
 from tempfile import mkdtemp
 from subprocess import run
 from ctypes import Structure, Array
+import ctypes
 from sys import stdout, stderr
 
 loaded_libs = {}
@@ -53,6 +54,7 @@ class State:
 
         self.num_actions = len(self.actions)
 
+        self._storage = None
         self.state = self.program.module.play()
 
     @property
@@ -79,9 +81,27 @@ class State:
                 x.append(action)
         return x
 
+    def bind_storage(self, storage):
+        # moves the state into `storage`, a Game owned by someone else,
+        # such as a element of a VectorTGameT shared by many environments,
+        # so that batched functions can see this state without copies.
+        self._storage = storage
+        self._store(self.state)
+
+    def _store(self, new_state):
+        if self._storage is None:
+            self.state = new_state
+            return
+        # the assignment releases what the storage owned and copies the
+        # buffers of new_state, which still frees its own when collected
+        self.module.lib.rl_m_assign__Game_Game(
+            ctypes.byref(self._storage), ctypes.byref(new_state)
+        )
+        self.state = self._storage
+
     def reset(self, seed=None, options=None, path_to_binary_state=None):
         if path_to_binary_state == None:
-            self.state = self.program.module.play()
+            self._store(self.program.module.play())
         else:
             self.load_binary(path_to_binary_state)
 
@@ -281,6 +301,9 @@ def _make_cl_args(
     gen_python_methods=True,
     stdlib=None,
     extra_rlc_args=[],
+    module_cache=None,
+    pgo_gen=None,
+    pgo_use=None,
 ):
     s = [source for source in sources]
     if gen_python_methods:
@@ -293,6 +316,11 @@ def _make_cl_args(
     if stdlib != None:
         include_args.append("-i")
         include_args.append(stdlib)
+    # both invocations parse the same files, the second one reads them from
+    # the cache filled by the first
+    if module_cache != None:
+        include_args.append("--module-cache")
+        include_args.append(module_cache)
 
     command_line_python = [
                 rlc_compiler,
@@ -320,6 +348,11 @@ def _make_cl_args(
         args = args + ["--runtime-lib", rlc_runtime_lib]
     if pyrlc_runtime_lib != None:
         args = args + ["--pyrlc-lib", pyrlc_runtime_lib]
+    # only the library contains code to instrument or to optimize
+    if pgo_gen != None:
+        args = args + ["--pgo-gen=" + pgo_gen]
+    if pgo_use != None:
+        args = args + ["--pgo-use", pgo_use]
     args = args + include_args
     return (command_line_python, args)
 
@@ -333,9 +366,35 @@ def compile(
     gen_python_methods=True,
     stdlib=None,
     extra_rlc_args=[],
+    module_cache=None,
+    pgo_gen=None,
+    pgo_use=None,
 ) -> Program:
     tmp_dir = mkdtemp()
-    (command_line_python, compiler) = _make_cl_args(tmp_dir, sources=sources, rlc_compiler=rlc_compiler, rlc_includes=rlc_includes, rlc_runtime_lib=rlc_runtime_lib, optimized=optimized, gen_python_methods=gen_python_methods, stdlib=stdlib, extra_rlc_args=extra_rlc_args, pyrlc_runtime_lib=pyrlc_runtime_lib)
+    (command_line_python, compiler) = _make_cl_args(tmp_dir, sources=sources, rlc_compiler=rlc_compiler, rlc_includes=rlc_includes, rlc_runtime_lib=rlc_runtime_lib, optimized=optimized, gen_python_methods=gen_python_methods, stdlib=stdlib, extra_rlc_args=extra_rlc_args, pyrlc_runtime_lib=pyrlc_runtime_lib, module_cache=module_cache, pgo_gen=pgo_gen, pgo_use=pgo_use)
     assert run(command_line_python).returncode == 0
     assert run(compiler).returncode == 0
     return Program(str(Path(tmp_dir) / Path("wrapper.py")), tmp_dir)
+
+def run_jit(
+    sources=[],
+    rlc_compiler="rlc",
+    rlc_includes=[],
+    rlc_runtime_lib="",
+    optimized=True,
+    stdlib=None,
+    extra_rlc_args=[],
+    module_cache=None,
+) -> int:
+    """Compiles the sources in memory and runs their main function, without
+    writing or linking any library. Returns the value returned by main."""
+    args = [rlc_compiler, *sources, "--jit"]
+    if optimized:
+        args.append("-O2")
+    for include in rlc_includes + ([stdlib] if stdlib != None else []):
+        args = args + ["-i", include]
+    if rlc_runtime_lib != "":
+        args = args + ["--runtime-lib", rlc_runtime_lib]
+    if module_cache != None:
+        args = args + ["--module-cache", module_cache]
+    return run(args + extra_rlc_args).returncode
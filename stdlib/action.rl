@@ -114,6 +114,33 @@ fun<FrameType, ActionType> get_valid_actions(Vector<Byte> valid_actions, Vector<
                 valid_actions[i] = byte(0)
         i = i + 1
 
+# fills `valid_actions` with a states.size() x all_actions.size()
+# row major mask, where row `i` holds what get_valid_actions would
+# write for states[i]. Used to compute the mask of many games with a
+# single call across the language boundary.
+#
+# each row is computed by get_valid_actions, that the compiler
+# forwards to the fused legal_action_mask of @classes actions.
+fun<FrameType, ActionType> get_valid_actions_batch(Vector<FrameType> states, Vector<ActionType> all_actions, Vector<Byte> valid_actions):
+    let num_actions = all_actions.size()
+    if valid_actions.size() != states.size() * num_actions:
+        valid_actions.resize(states.size() * num_actions)
+    let row : Vector<Byte>
+    row.resize(num_actions)
+    let state_index = 0
+    while state_index != states.size():
+        let offset = state_index * num_actions
+        let i = 0
+        while i != num_actions:
+            row[i] = valid_actions[offset + i]
+            i = i + 1
+        get_valid_actions(row, all_actions, states.get(state_index))
+        i = 0
+        while i != num_actions:
+            valid_actions[offset + i] = row[i]
+            i = i + 1
+        state_index = state_index + 1
+
 
 # method that bust be present in binary to ensure that all methods 
 # required by rlc-learn are available
@@ -145,6 +172,14 @@ fun<FrameType, AllActionsVariant> gen_python_methods(FrameType state, AllActions
     let v_byte : Vector<Byte>
     get_valid_actions(v_byte, vector, state)
     make_valid_actions_vector(vector, state)
+    let states : Vector<FrameType>
+    states.resize(1)
+    # python environments keep their states in the elements of a
+    # Vector<FrameType>, that they read with get and write with
+    # the assignment of FrameType
+    states.get(0) = state
+    get_valid_actions_batch(states, vector, v_byte)
+    write_observations(states, 0, observation_tensor_size(state), v_byte)
     emit_observation_tensor_warnings(state)
     print_enumeration_errors(variant)
 
@@ -307,6 +342,21 @@ fun write_in_observation_tensor(Int value, Int min, Int max, Vector<Float> outpu
         index = index + 1
         counter = counter + 1
 
+# same as write_in_observation_tensor, without bound checks,
+# that are done once for the whole tensor by to_observation_tensor
+fun _write_one_hot(Int value, Int min, Int max, Vector<Float> output, Int index):
+    _write_zeros(output, index, index + max - min)
+    if value >= min and value < max:
+        output._data[index + value - min] = 1.0
+    index = index + max - min
+
+# zeroes the slots of `output` in [index, end)
+# and moves `index` to `end`
+fun _write_zeros(Vector<Float> output, Int index, Int end):
+    while index < end:
+        output._data[index] = 0.0
+        index = index + 1
+
 
 fun write_in_observation_tensor(Int obj, Int observer_id, Vector<Float> output, Int index) :
     return
@@ -322,16 +372,16 @@ fun size_as_observation_tensor(Float obj) -> Int {false}:
 
 fun write_in_observation_tensor(Bool obj, Int observer_id, Vector<Float> output, Int index):
     if obj:
-        output.get(index) = 1.0
+        output._data[index] = 1.0
     else:
-        output.get(index) = 0.0
+        output._data[index] = 0.0
     index = index + 1
 
 fun size_as_observation_tensor(Bool obj) -> Int:
     return 1
 
 fun write_in_observation_tensor(Byte obj, Int observer_id, Vector<Float> output, Int index):
-    write_in_observation_tensor(int(obj), -128, 127, output, index)
+    _write_one_hot(int(obj), -128, 128, output, index)
 
 fun size_as_observation_tensor(Byte obj) -> Int:
     return 256
@@ -358,22 +408,24 @@ fun<T, Int max_size> write_in_observation_tensor(BoundedVector<T, max_size> obj,
         counter = counter + 1
 
 fun<T, Int max_size> size_as_observation_tensor(BoundedVector<T, max_size> obj) -> Int:
-    let t : T
-    return _size_as_observation_tensor_impl(t) * max_size
+    return _size_as_observation_tensor_impl(obj._data[0]) * max_size
 
 fun<Int min, Int max> write_in_observation_tensor(BInt<min, max> obj, Int observer_id, Vector<Float> output, Int index):
-    write_in_observation_tensor(obj.value, min, max, output, index)
+    _write_one_hot(obj.value, min, max, output, index)
 
 fun<Int min, Int max> size_as_observation_tensor(BInt<min, max> obj) -> Int:
     return max - min 
 
 fun<Int min, Int max> write_in_observation_tensor(LinearlyDistributedInt<min, max> obj, Int observer_id, Vector<Float> output, Int index):
-    output[index] = (float(obj.value) - (float(max - min) / 2.0)) / float(max-min)
+    output._data[index] = (float(obj.value) - (float(max - min) / 2.0)) / float(max-min)
     index = index + 1
 
 fun<Int min, Int max> size_as_observation_tensor(LinearlyDistributedInt<min, max> obj) -> Int:
     return 1
 
+# The size depends only on the type of `obj`, which
+# is never read, so once inlined it is a constant and
+# so is the offset of every field in the tensor.
 fun<T> _size_as_observation_tensor_impl(T obj) -> Int:
     if obj is Tensorable:
         return obj.size_as_observation_tensor()
@@ -381,13 +433,10 @@ fun<T> _size_as_observation_tensor_impl(T obj) -> Int:
         return obj.max() + 1
     else if obj is Alternative:
         let alternative_count = 0
-        for field of obj:
-            alternative_count = alternative_count + 1
         let max_size = 0
         for field of obj:
-            using Type = type(field)
-            let fake : Type
-            max_size = max(_size_as_observation_tensor_impl(fake), max_size)
+            alternative_count = alternative_count + 1
+            max_size = max(_size_as_observation_tensor_impl(field), max_size)
         return max_size + alternative_count
     else:
         let to_return = 0
@@ -395,39 +444,44 @@ fun<T> _size_as_observation_tensor_impl(T obj) -> Int:
             to_return = to_return + _size_as_observation_tensor_impl(field)
         return to_return
 
+# Every value ends exactly _size_as_observation_tensor_impl
+# slots after where it starts: the slots a custom writer or
+# a inactive alternative leave unused are zeroed. The layout
+# of the tensor is thus fixed, and since the sizes are
+# constants the writer reduces to a sequence of stores at
+# constant offsets.
 fun<T> _to_observation_tensor(T obj, Int observer_id, Vector<Float> output, Int index):
     if obj is Tensorable:
+        let end = index + obj.size_as_observation_tensor()
         obj.write_in_observation_tensor(observer_id, output, index)
-        return
+        _write_zeros(output, index, end)
     else if obj is Enum:
-        write_in_observation_tensor(obj.as_int(), 0, obj.max() + 1, output, index)
-        return
+        _write_one_hot(obj.as_int(), 0, obj.max() + 1, output, index)
     else if obj is Alternative:
+        let end = index + _size_as_observation_tensor_impl(obj)
         let alternative_count = 0
         for field of obj:
             alternative_count = alternative_count + 1
         let current = 0
-        let largest_field = _size_as_observation_tensor_impl(obj) - alternative_count
         for field of obj:
             using Type = type(field)
             if obj is Type:
-                let zeros_to_add = largest_field - _size_as_observation_tensor_impl(obj)
-                write_in_observation_tensor(current, 0, alternative_count, output, index)
+                _write_one_hot(current, 0, alternative_count, output, index)
                 _to_observation_tensor(field, observer_id, output, index)
-                while zeros_to_add != 0:
-                    zeros_to_add = zeros_to_add - 1
-                    output.get(index) = 0.0
-                    index = index + 1 
-                return
             current = current + 1
+        _write_zeros(output, index, end)
     else:
         for field of obj:
             _to_observation_tensor(field, observer_id, output, index)
 
 fun<T> to_observation_tensor(T obj, Int observer_id, Vector<Float> output):
-    _to_observation_tensor(obj, observer_id, output, 0)
+    to_observation_tensor(obj, observer_id, output, 0)
 
+# the bounds of `output` are checked once here,
+# the writers then store without checks
 fun<T> to_observation_tensor(T obj, Int observer_id, Vector<Float> output, Int written_bytes):
+    assert(written_bytes >= 0, "out of bound observation tensor write")
+    assert(written_bytes + _size_as_observation_tensor_impl(obj) <= output.size(), "out of bound observation tensor write")
     _to_observation_tensor(obj, observer_id, output, written_bytes)
 
 fun<T> to_observation_tensor(T obj, Int observer_id) -> Vector<Float>:
@@ -439,9 +493,62 @@ fun<T> to_observation_tensor(T obj, Int observer_id) -> Vector<Float>:
     _to_observation_tensor(obj, observer_id, output, 0)
     return output
 
+# rewrites in `output`, that holds a older tensor of
+# `obj`, only the regions of the fields of `obj` whose
+# bit is set in `dirty`. Field i maps to bit i % 63.
+# Used by the update_observation_tensor functions
+# emitted by rlc --incremental-observation.
+fun<T> _update_observation_tensor(T obj, Int dirty, Int observer_id, Vector<Float> output):
+    if obj is Tensorable:
+        to_observation_tensor(obj, observer_id, output, 0)
+    else:
+        assert(_size_as_observation_tensor_impl(obj) <= output.size(), "out of bound observation tensor write")
+        let index = 0
+        let field_index = 0
+        for field of obj:
+            let end = index + _size_as_observation_tensor_impl(field)
+            if ((dirty >> (field_index % 63)) & 1) != 0:
+                _to_observation_tensor(field, observer_id, output, index)
+            index = end
+            field_index = field_index + 1
+
 fun<T> observation_tensor_size(T obj) -> Int:
     return _size_as_observation_tensor_impl(obj)
 
+# fills `output` with a states.size() x stride row major
+# matrix of single precision floats in the byte order of
+# the target, where row `i` holds the observation tensor of
+# states[i] for `observer_id` followed by zeros. Used to
+# observe many games with a single call across the language
+# boundary, the caller can view `output` as a matrix of
+# float32.
+fun<FrameType> write_observations(Vector<FrameType> states, Int observer_id, Int stride, Vector<Byte> output):
+    if states.size() == 0:
+        return
+    let size = observation_tensor_size(states.get(0))
+    assert(size <= stride, "observation stride smaller than the observation tensor")
+    if output.size() != states.size() * stride * 4:
+        output.resize(states.size() * stride * 4)
+    let tensor : Vector<Float>
+    tensor.resize(size)
+    let state_index = 0
+    while state_index != states.size():
+        to_observation_tensor(states.get(state_index), observer_id, tensor, 0)
+        let index = state_index * stride * 4
+        let counter = 0
+        while counter != size:
+            __builtin_store_float32_do_not_use(output._data[index], tensor._data[counter])
+            index = index + 4
+            counter = counter + 1
+        while counter != stride:
+            output._data[index] = byte(0)
+            output._data[index + 1] = byte(0)
+            output._data[index + 2] = byte(0)
+            output._data[index + 3] = byte(0)
+            index = index + 4
+            counter = counter + 1
+        state_index = state_index + 1
+
 trait<T> CustomTensorWarnings:
     fun tensorable_warning(T x, String out, Vector<String> context) 
 
@@ -12,6 +12,7 @@
 # See the License for the specific language governing permissions and
 # limitations under the License.
 import serialization.to_byte_vector
+import serialization.to_packed_byte_vector
 import string 
 
 # A integer with a max and min, so that
@@ -157,6 +158,18 @@ fun<Int min, Int max> parse_from_vector(BInt<min, max> to_add, Vector<Byte> outp
         to_add.value = (value % (max - min)) + min
         return true
 
+# packs `value - min` in the bits needed
+# for the `max - min` possible values
+fun<Int min, Int max> append_to_packed_vector(BInt<min, max> to_add, Vector<Byte> output, Int written):
+    write_bits(to_add.value - min, bits_needed_for(max - min), output, written)
+
+fun<Int min, Int max> parse_from_packed_vector(BInt<min, max> to_add, Vector<Byte> input, Int read) -> Bool:
+    let value : Int
+    if !read_bits(value, bits_needed_for(max - min), input, read):
+        return false
+    to_add.value = (value % (max - min)) + min
+    return true
+
 fun<Int min, Int max> append_to_string(BInt<min, max> to_add, String output):
     append_to_string(to_add.value, output)
 
@@ -325,6 +338,17 @@ fun<Int min, Int max> parse_from_vector(LinearlyDistributedInt<min, max> to_add,
         to_add.value = (value % (max - min)) + min
         return true
 
+# same as the BInt overload
+fun<Int min, Int max> append_to_packed_vector(LinearlyDistributedInt<min, max> to_add, Vector<Byte> output, Int written):
+    write_bits(to_add.value - min, bits_needed_for(max - min), output, written)
+
+fun<Int min, Int max> parse_from_packed_vector(LinearlyDistributedInt<min, max> to_add, Vector<Byte> input, Int read) -> Bool:
+    let value : Int
+    if !read_bits(value, bits_needed_for(max - min), input, read):
+        return false
+    to_add.value = (value % (max - min)) + min
+    return true
+
 fun<Int min, Int max> append_to_string(LinearlyDistributedInt<min, max> to_add, String output):
     append_to_string(to_add.value, output)
 
@@ -17,223 +17,92 @@ import serialization.print
 import serialization.key_equal
 import collections.vector
 
+# Dict is a open addressing hash table that keeps, next to each
+# entry, a control byte that is either empty, deleted, or the low 7 bits of
+# the hash of the key stored in that slot. Slots are split in groups of 16,
+# and __builtin_match_group_do_not_use compares the control bytes of a whole
+# group at once, so entries are only loaded when their 7 bits match.
+#
+# The remaining bits of the hash select the first group to visit, then
+# groups are visited in triangular order, which reaches all of them because
+# the number of groups is a power of 2. A lookup stops at the first group
+# that has a empty slot, so removing a key leaves a deleted slot behind
+# unless its group already has a empty one.
+fun _dict_empty_slot() -> Byte:
+    return byte(-128)
+
+fun _dict_deleted_slot() -> Byte:
+    return byte(-2)
+
 cls<KeyType, ValueType> Entry:
-    Bool occupied
-    Int hash
     KeyType key
     ValueType value
 
 cls<KeyType, ValueType> Dict:
+    OwningPtr<Byte> _control
     OwningPtr<Entry<KeyType, ValueType>> _entries
     Int _size
+    Int _deleted
     Int _capacity
-    Float _max_load_factor
     
+    # nothing is allocated until the first insertion
     fun init():
-        self._capacity = 4
         self._size = 0
-        self._max_load_factor = 0.75
-        self._entries = __builtin_malloc_do_not_use<Entry<KeyType, ValueType>>(self._capacity)
-        let counter = 0
-        while counter < self._capacity:
-            self._entries[counter].occupied = false
-            counter = counter + 1
+        self._deleted = 0
+        self._capacity = 0
     
     fun insert(KeyType key, ValueType value) -> Bool:
-        let load_factor : Float
-        load_factor = float(self._size + 1) / float(self._capacity)
-        if load_factor > self._max_load_factor:
-            self._grow()
-        self._insert(self._entries, key, value)
-        return true
-    
-    fun _insert(OwningPtr<Entry<KeyType, ValueType>> entries, KeyType key, ValueType value):
         let hash = compute_hash_of(key)
-        let index = hash % self._capacity
-        let distance = 0
-        let probe_count = 0  # Add safety counter
-        
-        # Create local copies of key and value to avoid modifying the input parameters
-        let current_key = key
-        let current_value = value
-        let current_hash = hash
-
-        while true:
-            # Add safety check to prevent infinite loops
-            if probe_count >= self._capacity:
-                assert(false, "Maximum probe count exceeded - likely an implementation bug")
-                return
-            probe_count = probe_count + 1
-            
-            
-            if !entries[index].occupied:
-                __builtin_construct_do_not_use(entries[index])
-                let entry = entries[index]
-                entry.occupied = true
-                entry.hash = current_hash
-                entry.key = current_key
-                entry.value = current_value
-                entries[index] = entry  # Update the actual entry in entries
-                self._size = self._size + 1
-                return
-            else if entries[index].hash == current_hash and compute_equal_of(entries[index].key, current_key):
-                ref entry = entries[index]
-                entry.value = current_value
-                entries[index] = entry  # Update the actual entry in entries
-                return
-            else:
-                ref entry = entries[index]
-                let existing_entry_distance = (index + self._capacity - (entry.hash % self._capacity)) % self._capacity
-                if existing_entry_distance < distance:
-                    let temp_entry = entry
-                    entry.hash = current_hash
-                    entry.key = current_key
-                    entry.value = current_value
-                    entries[index] = entry  # Update the swapped entry
-                    current_hash = temp_entry.hash
-                    current_key = temp_entry.key
-                    current_value = temp_entry.value
-                    distance = existing_entry_distance
-                distance = distance + 1
-                index = (index + 1) % self._capacity
+        let slot = self._find(key, hash)
+        if slot != -1:
+            self._entries[slot].value = value
+            return true
+        # keep at least a slot in eight empty, so that lookups
+        # of missing keys stop early
+        if (self._size + self._deleted + 1) * 8 > self._capacity * 7:
+            self._rehash()
+        self._insert_new(key, value, hash)
+        return true
     
     fun get(KeyType key) -> ValueType:
-        # Quick return for empty dictionary
-        if self._size == 0:
-            assert(false, "key not found in empty dictionary")
-        
-        let hash = compute_hash_of(key)
-        let index = hash % self._capacity
-        let distance = 0
-        let probe_count = 0  # Add safety counter
-
-        while true:
-            # Add safety check to prevent infinite loops
-            if probe_count >= self._capacity:
-                assert(false, "GET: Maximum probe count exceeded - likely an implementation bug")
-            probe_count = probe_count + 1
-            
-            ref entry = self._entries[index]
-            
-            if !entry.occupied:
-                assert(false, "key not found")
-            else if entry.hash == hash and compute_equal_of(entry.key, key):
-                return entry.value
-            else:
-                let existing_entry_distance = (index + self._capacity - (entry.hash % self._capacity)) % self._capacity
-                if existing_entry_distance < distance:
-                    assert(false, "key not found")
-                distance = distance + 1
-                index = (index + 1) % self._capacity
-        return self._entries[index].value
+        let slot = self._find(key, compute_hash_of(key))
+        if slot == -1:
+            assert(false, "key not found")
+        return self._entries[slot].value
     
     fun contains(KeyType key) -> Bool:
-        # Quick return for empty dictionary
-        if self._size == 0:
-            return false
-        
-        let hash = compute_hash_of(key)
-        let index = hash % self._capacity
-        let distance = 0
-        let probe_count = 0  # Add safety counter
-        let to_return : Bool
-        to_return = false
-
-        while true:
-            # Add safety check to prevent infinite loops
-            if probe_count >= self._capacity:
-                assert(false, "CONTAINS: Maximum probe count exceeded - likely an implementation bug")
-            probe_count = probe_count + 1
-            
-            ref entry = self._entries[index]
-            
-            if !entry.occupied:
-                break
-            else if entry.hash == hash and compute_equal_of(entry.key, key):
-                to_return = true
-                break
-            else:
-                let existing_entry_distance = (index + self._capacity - (entry.hash % self._capacity)) % self._capacity
-                if existing_entry_distance < distance:
-                    break
-                distance = distance + 1
-                index = (index + 1) % self._capacity
-        return to_return
+        return self._find(key, compute_hash_of(key)) != -1
     
     fun remove(KeyType key) -> Bool:
-        let hash = compute_hash_of(key)
-        let index = hash % self._capacity
-        let distance = 0
-        let probe_count = 0  # Add safety counter
+        let slot = self._find(key, compute_hash_of(key))
+        if slot == -1:
+            return false
 
-        while true:
-            # Add safety check to prevent infinite loops
-            if probe_count >= self._capacity:
-                assert(false, "REMOVE: Maximum probe count exceeded - likely an implementation bug")
-                return false
-            probe_count = probe_count + 1
-            
-            ref entry = self._entries[index]
-            
-            if !entry.occupied:
-                break
-            else if entry.hash == hash and compute_equal_of(entry.key, key):
-                self._size = self._size - 1
-                
-                # Perform backward-shift operation
-                let next_index = (index + 1) % self._capacity
-                let current_index = index
-                
-                # Shift elements until we find an empty slot or an element with probe distance 0
-                while true:
-                    let next_entry = self._entries[next_index]
-                    if !next_entry.occupied:
-                        self._entries[current_index].occupied = false
-                        break
-                    
-                    # Calculate probe distance of the next element
-                    let next_probe_distance = (next_index + self._capacity - (next_entry.hash % self._capacity)) % self._capacity
-                    
-                    # If probe distance is 0, it's already at its ideal position
-                    if next_probe_distance == 0:
-                        self._entries[current_index].occupied = false
-                        break
-                    
-                    # Move the element back
-                    self._entries[current_index] = next_entry
-                    
-                    # Move to next positions
-                    current_index = next_index
-                    next_index = (next_index + 1) % self._capacity
-                
-                return true
-            else:
-                let existing_entry_distance = (index + self._capacity - (entry.hash % self._capacity)) % self._capacity
-                if existing_entry_distance < distance:
-                    break
-                distance = distance + 1
-                index = (index + 1) % self._capacity
-        return false
+        __builtin_destroy_do_not_use(self._entries[slot])
+        self._size = self._size - 1
+        let first_slot = slot - (slot & 15)
+        if __builtin_match_group_do_not_use(self._control, first_slot, _dict_empty_slot()) != 0:
+            self._control[slot] = _dict_empty_slot()
+        else:
+            self._control[slot] = _dict_deleted_slot()
+            self._deleted = self._deleted + 1
+        return true
     
     fun keys() -> Vector<KeyType>:
         let to_return : Vector<KeyType>
-        let counter = 0
         let index = 0
-        while counter < self._size:
-            if self._entries[index].occupied:
+        while index < self._capacity:
+            if self._is_full(index):
                 to_return.append(self._entries[index].key)
-                counter = counter + 1
             index = index + 1
         return to_return
 
     fun values() -> Vector<ValueType>:
         let to_return : Vector<ValueType>
-        let counter = 0
         let index = 0
-        while counter < self._size:
-            if self._entries[index].occupied:
+        while index < self._capacity:
+            if self._is_full(index):
                 to_return.append(self._entries[index].value)
-                counter = counter + 1
             index = index + 1
         return to_return
 
@@ -250,68 +119,122 @@ cls<KeyType, ValueType> Dict:
         return self._size
 
     # erases all the elements
-    # of the dictionary
+    # of the dictionary, the memory
+    # is kept for the next insertions
     fun clear():
         let counter = 0
         while counter < self._capacity:
-            __builtin_destroy_do_not_use(self._entries[counter])
+            if self._is_full(counter):
+                __builtin_destroy_do_not_use(self._entries[counter])
+            self._control[counter] = _dict_empty_slot()
             counter = counter + 1
-        __builtin_free_do_not_use(self._entries)
-
-        self._capacity = 4
         self._size = 0
-        self._entries = __builtin_malloc_do_not_use<Entry<KeyType, ValueType>>(self._capacity)
+        self._deleted = 0
+
+    fun drop():
         let counter = 0
         while counter < self._capacity:
-            self._entries[counter].occupied = false
+            if self._is_full(counter):
+                __builtin_destroy_do_not_use(self._entries[counter])
             counter = counter + 1
+        if self._capacity != 0:
+            __builtin_free_do_not_use(self._control)
+            __builtin_free_do_not_use(self._entries)
+        self._size = 0
+        self._deleted = 0
+        self._capacity = 0
 
-    fun _grow():
-        let old_capacity = self._capacity
+    fun _is_full(Int slot) -> Bool:
+        let control = self._control[slot]
+        return control != _dict_empty_slot() and control != _dict_deleted_slot()
+
+    # returns the slot holding key, or -1 if there is none
+    fun _find(KeyType key, Int hash) -> Int:
+        if self._capacity == 0:
+            return -1
+        let tag = byte(hash & 127)
+        let group_mask = (self._capacity >> 4) - 1
+        let group = (hash >> 7) & group_mask
+        let step = 0
+        while step <= group_mask:
+            let first_slot = group << 4
+            let matches = __builtin_match_group_do_not_use(self._control, first_slot, tag)
+            let slot = first_slot
+            while matches != 0:
+                if (matches & 1) != 0:
+                    if compute_equal_of(self._entries[slot].key, key):
+                        return slot
+                matches = matches >> 1
+                slot = slot + 1
+            if __builtin_match_group_do_not_use(self._control, first_slot, _dict_empty_slot()) != 0:
+                return -1
+            step = step + 1
+            group = (group + step) & group_mask
+        return -1
+
+    # returns the first empty or deleted slot of the probe sequence of hash,
+    # there is always one since the table is never full
+    fun _find_free_slot(Int hash) -> Int:
+        let group_mask = (self._capacity >> 4) - 1
+        let group = (hash >> 7) & group_mask
+        let step = 0
+        while step <= group_mask:
+            let first_slot = group << 4
+            let available = __builtin_match_group_do_not_use(self._control, first_slot, _dict_empty_slot())
+            available = available | __builtin_match_group_do_not_use(self._control, first_slot, _dict_deleted_slot())
+            if available != 0:
+                let slot = first_slot
+                while (available & 1) == 0:
+                    available = available >> 1
+                    slot = slot + 1
+                return slot
+            step = step + 1
+            group = (group + step) & group_mask
+        assert(false, "dictionary has no free slot - likely an implementation bug")
+        return -1
+
+    # inserts a key that is known not to be in the dictionary
+    fun _insert_new(KeyType key, ValueType value, Int hash):
+        let slot = self._find_free_slot(hash)
+        if self._control[slot] == _dict_deleted_slot():
+            self._deleted = self._deleted - 1
+        self._control[slot] = byte(hash & 127)
+        __builtin_construct_do_not_use(self._entries[slot])
+        self._entries[slot].key = key
+        self._entries[slot].value = value
+        self._size = self._size + 1
+
+    # moves every element in a new table that is at most 7/16 full, so it
+    # doubles when the table is full of elements, and keeps the same
+    # capacity when it is full of deleted slots.
+    fun _rehash():
+        let new_capacity = 16
+        while (self._size + 1) * 16 > new_capacity * 7:
+            new_capacity = new_capacity * 2
+
+        let old_control = self._control
         let old_entries = self._entries
-        let old_size = self._size
-        
-        # Create new, larger entries array
-        self._capacity = self._next_power_of_2(self._capacity + 1)  # Ensures growth by at least 1
-        self._entries = __builtin_malloc_do_not_use<Entry<KeyType, ValueType>>(self._capacity)
+        let old_capacity = self._capacity
+
+        self._capacity = new_capacity
         self._size = 0
-        
-        # Initialize new entries
+        self._deleted = 0
+        self._control = __builtin_malloc_do_not_use<Byte>(new_capacity)
+        self._entries = __builtin_malloc_do_not_use<Entry<KeyType, ValueType>>(new_capacity)
         let counter = 0
-        while counter < self._capacity:
-            self._entries[counter].occupied = false
+        while counter < new_capacity:
+            self._control[counter] = _dict_empty_slot()
             counter = counter + 1
 
-        # Copy old entries to new array, but only scan up to old_capacity
         counter = 0
         while counter < old_capacity:
-            if old_entries[counter].occupied:
-                # Insert directly without triggering another growth
-                self._insert(self._entries, old_entries[counter].key, old_entries[counter].value)
+            let control = old_control[counter]
+            if control != _dict_empty_slot() and control != _dict_deleted_slot():
+                let hash = compute_hash_of(old_entries[counter].key)
+                self._insert_new(old_entries[counter].key, old_entries[counter].value, hash)
+                __builtin_destroy_do_not_use(old_entries[counter])
             counter = counter + 1
-        
-        # Clean up old entries
-        counter = 0
-        while counter < old_capacity:
-            __builtin_destroy_do_not_use(old_entries[counter])
-            counter = counter + 1
-        
-        __builtin_free_do_not_use(old_entries)
-        return
-
-    fun drop():
-        let counter = 0
-        while counter < self._capacity:
-            __builtin_destroy_do_not_use(self._entries[counter])
-            counter = counter + 1
-        if self._capacity != 0:
-            __builtin_free_do_not_use(self._entries)
-        self._size = 0
-        self._capacity = 0
 
-    # Private utility to find next power of 2
-    fun _next_power_of_2(Int value) -> Int:
-        let result = 1
-        while result < value:
-            result = result * 2
-        return result
+        if old_capacity != 0:
+            __builtin_free_do_not_use(old_control)
+            __builtin_free_do_not_use(old_entries)
@@ -18,47 +18,36 @@
 # the contents may be reallocated when added or deleated,
 # so references elements are invalidated if the 
 # vector is modified.
+#
+# Only the first `_size` slots hold constructed
+# elements, the rest of the capacity is raw memory.
 cls<T> Vector:
     OwningPtr<T> _data
     Int _size
     Int _capacity
 
+    # rlc values never store their own address,
+    # so elements are moved to the new buffer by
+    # realloc with a plain memory copy, without
+    # copying or destroying them one by one.
     fun _grow(Int target_size):
         if self._capacity > target_size:
             return
 
-        let new_data = __builtin_malloc_do_not_use<T>(target_size * 2)
-        let counter = 0
-        while counter < target_size * 2:
-            __builtin_construct_do_not_use(new_data[counter])
-            counter = counter + 1
-
-        counter = 0
-        while counter < self._size:
-            new_data[counter] = self._data[counter] 
-            counter = counter + 1
-
-        counter = 0
-        while counter < self._capacity:
-            __builtin_destroy_do_not_use(self._data[counter])
-            counter = counter + 1
-
-        __builtin_free_do_not_use(self._data)
+        if self._capacity == 0:
+            self._data = __builtin_malloc_do_not_use<T>(target_size * 2)
+        else:
+            self._data = __builtin_realloc_do_not_use(self._data, target_size * 2)
         self._capacity = target_size * 2
-        self._data = new_data
 
     fun init():
         self._size = 0
         self._capacity = 4
         self._data = __builtin_malloc_do_not_use<T>(4)
-        let counter = 0
-        while counter < self._capacity:
-            __builtin_construct_do_not_use(self._data[counter])
-            counter = counter + 1
 
     fun drop():
         let counter = 0
-        while counter != self._capacity:
+        while counter != self._size:
             __builtin_destroy_do_not_use(self._data[counter])
             counter = counter + 1
         if self._capacity != 0:
@@ -66,13 +55,22 @@ cls<T> Vector:
         self._size = 0
         self._capacity = 0
 
+    # copies the elements of `other` into the
+    # current buffer, allocating at most once
+    # instead of growing while appending
     fun assign(Vector<T> other):
-        self.drop()
-        self.init()
+        if other._size < self._size:
+            self.drop_back(self._size - other._size)
+        self._grow(other._size)
         let counter = 0
+        while counter < self._size:
+            self._data[counter] = other._data[counter]
+            counter = counter + 1
         while counter < other._size:
-            self.append(other.get(counter))
+            __builtin_construct_do_not_use(self._data[counter])
+            self._data[counter] = other._data[counter]
             counter = counter + 1
+        self._size = other._size
 
     # changes the size of the vector
     # to be equal to `new_size`
@@ -86,9 +84,9 @@ cls<T> Vector:
     fun resize(Int new_size):
         if new_size > self._size:
           self._grow(new_size)
-          let x : T
           while self._size != new_size:
-            self.append(x)
+            __builtin_construct_do_not_use(self._data[self._size])
+            self._size = self._size + 1
         else:
           while self._size > new_size:
             self.pop()
@@ -118,6 +116,7 @@ cls<T> Vector:
     # end of the vector
     fun append(T value):
         self._grow(self._size + 1)
+        __builtin_construct_do_not_use(self._data[self._size])
         self._data[self._size] = value
         self._size = self._size + 1
 
@@ -141,7 +140,6 @@ cls<T> Vector:
         let to_return = self._data[self._size - 1]
         self._size = self._size - 1
         __builtin_destroy_do_not_use(self._data[self._size])
-        __builtin_construct_do_not_use(self._data[self._size])
         return to_return
 
     # removes `quantity` elements
@@ -150,7 +148,6 @@ cls<T> Vector:
         let counter = self._size - quantity
         while counter < self._size: 
             __builtin_destroy_do_not_use(self._data[counter])
-            __builtin_construct_do_not_use(self._data[counter])
             counter = counter + 1
         self._size = self._size - quantity
 
@@ -168,21 +165,25 @@ cls<T> Vector:
     fun size() -> Int:
         return self._size
 
-# A bounded vector is a wrapper
-# around a vector that prevents 
-# the size of the vector to ever 
-# exced `max_size`
+# A bounded vector is a vector
+# that can never hold more than
+# `max_size` elements. The elements
+# are stored inline, so it needs no
+# heap allocation and a object
+# holding it can be copied as
+# a flat block of memory.
 # this class is usefull when used
 # for machine learning techniques, 
 # since it allows the machine learning
 # to know the maximal possible size
 # of this vector when converted to
 # a tensor
+#
+# The slots after `_size` always hold
+# default constructed elements.
 cls<T, Int max_size> BoundedVector:
-    Vector<T> _data
-
-    fun assign(BoundedVector<T, max_size> other):
-        self._data = other._data
+    T[max_size] _data
+    Int _size
 
     # identical to Vector::resize,
     # except `new_size` is clamped
@@ -190,7 +191,10 @@ cls<T, Int max_size> BoundedVector:
     fun resize(Int new_size):
         if new_size > max_size:
             new_size = max_size
-        self._data.resize(new_size)
+        if new_size < self._size:
+            self.drop_back(self._size - new_size)
+        else:
+            self._size = new_size
 
     # returns the maximal possible
     # size of this vector
@@ -199,44 +203,64 @@ cls<T, Int max_size> BoundedVector:
 
     # same as vector::back
     fun back() -> ref T:
-        return self._data.back()
+        assert(self._size > 0, "out of bound vector access")
+        return self._data[self._size - 1]
 
     # same as vector::get
     fun get(Int index) -> ref T:
-        return self._data.get(index)
+        assert(index >= 0, "out of bound vector access")
+        assert(index < self._size, "out of bound vector access")
+        return self._data[index]
 
     # same as vector::set
     fun set(Int index, T value):
-        self._data.set(index, value)
+        assert(index >= 0, "out of bound vector access")
+        assert(index < self._size, "out of bound vector access")
+        self._data[index] = value
 
     # append `value` to the end
     # of the vector, but only if
     # doing so would not excede
     # max vector maximal size
     fun append(T value): 
-        if max_size > self.size():
-          self._data.append(value)
+        if max_size > self._size:
+          self._data[self._size] = value
+          self._size = self._size + 1
 
     # same as vector::empty
     fun empty() -> Bool:
-        return self._data.empty()
+        return self._size == 0
 
     # same as vector::clear
     fun clear():
-        self._data.clear()
+        self.drop_back(self._size)
 
     # same as vector::pop
     fun pop() -> T:
-        return self._data.pop()
+        assert(self._size > 0, "out of bound vector access")
+        let to_return = self._data[self._size - 1]
+        self.drop_back(1)
+        return to_return
 
     # same as vector::drop_back
     fun drop_back(Int quantity):
-        self._data.drop_back(quantity)
+        let counter = self._size - quantity
+        while counter < self._size: 
+            __builtin_destroy_do_not_use(self._data[counter])
+            __builtin_construct_do_not_use(self._data[counter])
+            counter = counter + 1
+        self._size = self._size - quantity
 
     # same as vector::erase
     fun erase(Int index):
-        self._data.erase(index)
+        assert(index >= 0, "out of bound vector access")
+        assert(index < self._size, "out of bound vector access")
+        let counter = index
+        while counter < self._size - 1: 
+            self._data[counter] = self._data[counter + 1]
+            counter = counter + 1
+        self.drop_back(1)
 
     # same as vector::size
     fun size() -> Int:
-        return self._data.size()
+        return self._size
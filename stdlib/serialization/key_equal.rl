@@ -49,6 +49,17 @@ fun<T> compute_equal(Vector<T> vector1, Vector<T> vector2) -> Bool:
         counter = counter + 1
     return true
 
+fun<T, Int max_size> compute_equal(BoundedVector<T, max_size> vector1, BoundedVector<T, max_size> vector2) -> Bool:
+    if !(vector1.size() == vector2.size()):
+        return false
+    let counter : Int
+    counter = 0
+    while counter < vector1.size():
+        if !(compute_equal_of(vector1.get(counter), vector2.get(counter))):
+            return false
+        counter = counter + 1
+    return true
+
 fun<T, Int N> compute_equal(T[N] array1, T[N] array2) -> Bool:
     let counter : Int
     counter = 0
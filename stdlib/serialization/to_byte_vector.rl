@@ -21,19 +21,54 @@ import enum_utils
 trait<T> ByteVectorSerializable:
     fun append_to_vector(T to_add, Vector<Byte> output)
 
+# true if `value` is serialized as the bytes it
+# is stored in, that is it is made only of ints,
+# floats, bools and bytes, without padding and
+# without any part customizing its serialization.
+# `value` is never read, and the result is known
+# at compile time.
+fun<T> _is_memory_serializable(T value) -> Bool:
+    if value is Int:
+        return true
+    else if value is Float:
+        return true
+    else if value is Bool:
+        return true
+    else if value is Byte:
+        return true
+    else if value is ByteVectorSerializable:
+        return false
+    else if value is ByteVectorParsable:
+        return false
+    else if value is Alternative:
+        return false
+    else:
+        let size = 0
+        for field of value:
+            if !_is_memory_serializable(field):
+                return false
+            size = size + __builtin_size_of_do_not_use(field)
+        return size == __builtin_size_of_do_not_use(value)
+
+# appends the bytes of `count` contiguous values,
+# the first of which is `first`, with a single
+# reservation and copy
+fun<T> _append_memory(T first, Int count, Vector<Byte> output):
+    if count <= 0:
+        return
+    let size = count * __builtin_size_of_do_not_use(first)
+    output._grow(output._size + size)
+    __builtin_copy_bytes_do_not_use(output._data[output._size], first, size)
+    output._size = output._size + size
+
+fun<T> _append_memory(T value, Vector<Byte> output):
+    _append_memory(value, 1, output)
+
 fun append_to_vector(Int to_add, Vector<Byte> output):
-    let array = __builtin_to_array(to_add)  
-    let counter = 0
-    while counter < 8:
-        output.append(array[counter])
-        counter = counter + 1 
+    _append_memory(to_add, output)
 
 fun append_to_vector(Float to_add, Vector<Byte> output):
-    let array = __builtin_to_array(to_add)  
-    let counter = 0
-    while counter < 8:
-        output.append(array[counter])
-        counter = counter + 1 
+    _append_memory(to_add, output)
 
 fun append_to_vector(Bool to_add, Vector<Byte> output):
     let array = __builtin_to_array(to_add)  
@@ -44,20 +79,36 @@ fun append_to_vector(Byte to_add, Vector<Byte> output):
 
 fun<Enum T> append_to_vector(T to_add, Vector<Byte> output):
     let value = to_add.as_int()
-    let array = __builtin_to_array(value)  
+    _append_memory(value, output)
+
+fun<T> append_to_vector(Vector<T> to_add, Vector<Byte> output):
+    append_to_vector(to_add.size(), output)
+    # the first element is not read, it is only
+    # used to know the type of the elements
+    if _is_memory_serializable(to_add._data[0]):
+        _append_memory(to_add._data[0], to_add.size(), output)
+        return
     let counter = 0
-    while counter < 8:
-        output.append(array[counter])
+    while counter < to_add.size():
+        _to_vector_impl(to_add.get(counter), output)
         counter = counter + 1 
 
-fun<T> append_to_vector(Vector<T> to_add, Vector<Byte> output):
+# bounded vectors are serialized like vectors,
+# the unused slots are not written
+fun<T, Int max_size> append_to_vector(BoundedVector<T, max_size> to_add, Vector<Byte> output):
     append_to_vector(to_add.size(), output)
+    if _is_memory_serializable(to_add._data[0]):
+        _append_memory(to_add._data[0], to_add.size(), output)
+        return
     let counter = 0
     while counter < to_add.size():
         _to_vector_impl(to_add.get(counter), output)
         counter = counter + 1 
 
 fun<T, Int X> append_to_vector(T[X] to_add, Vector<Byte> output):
+    if _is_memory_serializable(to_add[0]):
+        _append_memory(to_add, output)
+        return
     let counter = 0
     while counter < X:
         _to_vector_impl(to_add[counter], output)
@@ -75,6 +126,11 @@ fun<T> _to_vector_impl(T to_add, Vector<Byte> output):
                 _to_vector_impl(to_add, output)
             counter = counter + 1
     else:
+        # structs made only of numbers, such as most
+        # frames, are copied in one go
+        if _is_memory_serializable(to_add):
+            _append_memory(to_add, output)
+            return
         for field of to_add:
             _to_vector_impl(field, output)
 
@@ -84,6 +140,9 @@ fun<T> append_to_byte_vector(T to_convert, Vector<Byte> out):
     _to_vector_impl(to_convert, out)
 
 # converts `to_convert` to a sequence of bytes 
+# Parts made only of ints, floats, bools and bytes,
+# including arrays and vectors of them, are copied
+# with a single memcpy, which yields the same bytes.
 fun<T> as_byte_vector(T to_convert) -> Vector<Byte>:
     let vec : Vector<Byte>
     _to_vector_impl(to_convert, vec)
@@ -95,30 +154,36 @@ fun<T> as_byte_vector(T to_convert) -> Vector<Byte>:
 trait<T> ByteVectorParsable:
     fun parse_from_vector(T result, Vector<Byte> input, Int index) -> Bool
 
-fun parse_from_vector(Int result, Vector<Byte> input, Int index) -> Bool:
-    if index + 8 > input.size():
+# true if `input` holds `count` values of
+# `size` bytes each starting at `index`
+fun _has_bytes(Vector<Byte> input, Int index, Int count, Int size) -> Bool:
+    if index < 0 or count < 0 or index > input.size():
         return false
-    let to_parse : Byte[8]
-    let counter = 0
-    while counter < 8:
-        to_parse[counter] = input.get(index)
-        index = index + 1   
-        counter = counter + 1 
-    result = __builtin_from_array<Int>(to_parse)    
-    return true
+    if size == 0:
+        return true
+    return count <= (input.size() - index) / size
 
-fun parse_from_vector(Float result, Vector<Byte> input, Int index) -> Bool:
-    if input.size() < index + 8:
+# the inverse of _append_memory, copies the bytes
+# of `count` contiguous values, the first of which
+# is `first`, out of `input` with a single copy
+fun<T> _parse_memory(T first, Int count, Vector<Byte> input, Int index) -> Bool:
+    let size = __builtin_size_of_do_not_use(first)
+    if !_has_bytes(input, index, count, size):
         return false
-    let to_parse : Byte[8]
-    let counter = 0
-    while counter < 8:
-        to_parse[counter] = input.get(index)
-        index = index + 1   
-        counter = counter + 1 
-    result = __builtin_from_array<Float>(to_parse)  
+    if count != 0:
+        __builtin_copy_bytes_do_not_use(first, input._data[index], count * size)
+    index = index + count * size
     return true
 
+fun<T> _parse_memory(T result, Vector<Byte> input, Int index) -> Bool:
+    return _parse_memory(result, 1, input, index)
+
+fun parse_from_vector(Int result, Vector<Byte> input, Int index) -> Bool:
+    return _parse_memory(result, input, index)
+
+fun parse_from_vector(Float result, Vector<Byte> input, Int index) -> Bool:
+    return _parse_memory(result, input, index)
+
 fun parse_from_vector(Bool result, Vector<Byte> input, Int index) -> Bool:
     if input.size() <= index:
         return false
@@ -139,6 +204,34 @@ fun<T> parse_from_vector(Vector<T> output, Vector<Byte> input, Int index) -> Boo
     let size : Int
     if !parse_from_vector(size, input, index):
         return false
+    if _is_memory_serializable(output._data[0]):
+        if !_has_bytes(input, index, size, __builtin_size_of_do_not_use(output._data[0])):
+            return false
+        output._grow(output._size + size)
+        _parse_memory(output._data[output._size], size, input, index)
+        output._size = output._size + size
+        return true
+    let counter = 0
+    while counter < size:
+        let raw : T
+        if !_from_vector_impl(raw, input, index):
+            return false
+        output.append(raw)
+        counter = counter + 1 
+    return true
+
+fun<T, Int max_size> parse_from_vector(BoundedVector<T, max_size> output, Vector<Byte> input, Int index) -> Bool:
+    let size : Int
+    if !parse_from_vector(size, input, index):
+        return false
+    if size < 0 or size > max_size:
+        return false
+    output.clear()
+    if _is_memory_serializable(output._data[0]):
+        if !_parse_memory(output._data[0], size, input, index):
+            return false
+        output._size = size
+        return true
     let counter = 0
     while counter < size:
         let raw : T
@@ -158,6 +251,8 @@ fun<Enum X> parse_from_vector(X to_add, Vector<Byte> input, Int index) -> Bool:
     return success
 
 fun<T, Int X> parse_from_vector(T[X] to_add, Vector<Byte> input, Int index) -> Bool:
+    if _is_memory_serializable(to_add[0]):
+        return _parse_memory(to_add, input, index)
     let counter = 0
     while counter < X:
         if !_from_vector_impl(to_add[counter], input, index):
@@ -183,6 +278,8 @@ fun<T> _from_vector_impl(T to_add, Vector<Byte> input, Int index) -> Bool:
             counter = counter - 1
         return false
     else:
+        if _is_memory_serializable(to_add):
+            return _parse_memory(to_add, input, index)
         for field of to_add:
             if !_from_vector_impl(field, input, index):
                 return false
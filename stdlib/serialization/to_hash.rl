@@ -29,17 +29,12 @@ fun compute_hash(Int value) -> Int:
     return x & 9223372036854775807  # Ensure positive value (mask with INT64_MAX)
 
 fun compute_hash(Float value) -> Int:
-    # Improved float hash using bit representation
-    # First convert to bits, then hash those bits as an integer
-    # For simplicity, we're still using the multiplication approach
-    # A better implementation would use IEEE 754 bit representation
-    let x = int(value * 1000000.0)
-    x = x ^ (x >> 33)
-    x = x * 1099511628211
-    x = x ^ (x >> 33)
-    x = x * 16777619
-    x = x ^ (x >> 33)
-    return x & 9223372036854775807
+    # hashes the IEEE 754 representation, 0.0 and -0.0
+    # are equal so they must hash the same
+    let x = value
+    if x == 0.0:
+        x = 0.0
+    return __builtin_hash_bytes_do_not_use(x) & 9223372036854775807
 
 fun compute_hash(Bool value) -> Int:
     if value:
@@ -54,30 +49,39 @@ fun compute_hash(Byte value) -> Int:
     x = (x ^ (x << 16)) * 72955717
     return x & 9223372036854775807
 
-# Add String hashing - assuming a String type exists
-# Using FNV-1a hash algorithm which is fast and has good distribution
+# hashes the characters of the string, without
+# the terminator, in a single pass
 fun compute_hash(String str) -> Int:
-    let hash = 2166136261  # Smaller FNV offset basis to avoid issues with large constants
-    let fnv_prime = 16777619  # Smaller FNV prime
-    
-    let i = 0
-    while i < str.size():
-        let char_value = int(str[i])
-        hash = hash ^ char_value
-        hash = (hash * fnv_prime) & 9223372036854775807
-        i = i + 1
-    
-    return hash
+    return __builtin_hash_bytes_do_not_use(str._data._data, str.size()) & 9223372036854775807
 
 # Implementations for collections
 fun<T> compute_hash(Vector<T> vector) -> Int:
+    # the first element is not read, it is only
+    # used to know the type of the elements
+    if __builtin_is_plain_data_do_not_use(vector._data[0]):
+        return __builtin_hash_bytes_do_not_use(vector._data, vector.size()) & 9223372036854775807
     let hash = 1
     for element of vector:
         # Improved combination formula
         hash = (hash * 31 + compute_hash_of(element)) & 9223372036854775807
     return hash
 
+# only the elements in use are hashed, but
+# plain vectors are hashed whole, since
+# their unused slots are always the same
+fun<T, Int max_size> compute_hash(BoundedVector<T, max_size> vector) -> Int:
+    if __builtin_is_plain_data_do_not_use(vector):
+        return __builtin_hash_bytes_do_not_use(vector) & 9223372036854775807
+    let hash = 1
+    let counter = 0
+    while counter < vector.size():
+        hash = (hash * 31 + compute_hash_of(vector.get(counter))) & 9223372036854775807
+        counter = counter + 1
+    return hash
+
 fun<T, Int N> compute_hash(T[N] array) -> Int:
+    if __builtin_is_plain_data_do_not_use(array):
+        return __builtin_hash_bytes_do_not_use(array) & 9223372036854775807
     let hash = 1
     for element of array:
         # Improved combination formula
@@ -98,6 +102,11 @@ fun<T> _hash_impl(T value) -> Int:
             counter = counter + 1
         return 0  # Should never reach here if alternative is valid
     else:
+        # structs made only of integers and bools,
+        # such as most frames, are hashed in one go
+        if __builtin_is_plain_data_do_not_use(value):
+            return __builtin_hash_bytes_do_not_use(value) & 9223372036854775807
+
         # Improved struct hashing that's more resilient across platforms
         let hash = 17  # Start with a prime number
         let field_count = 0
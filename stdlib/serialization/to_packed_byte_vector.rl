@@ -0,0 +1,264 @@
+# Copyright 2024 Massimo Fioravanti
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#    http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+import collections.vector
+import enum_utils
+
+# Compact alternative to to_byte_vector.rl. Values
+# are written as a stream of bits instead of bytes,
+# and each one takes only the bits needed to tell
+# apart its possible values: a bool takes one bit,
+# a enum takes enough bits for its `max()`, and
+# bounded ints such as BInt<min, max> take
+# ceil(log2(max - min)) bits. Ints and floats still
+# take 64 bits. Bits are stored starting from the
+# lowest bit of each byte, and the last byte is
+# padded with zeros.
+#
+# The positions used by the functions of this file
+# are counted in bits, not bytes.
+
+# returns the number of bits needed to store
+# `count` different values
+fun bits_needed_for(Int count) -> Int:
+    let bits = 0
+    while bits < 63 and (1 << bits) < count:
+        bits = bits + 1
+    return bits
+
+# appends the `bits` lowest bits of `value` to `output`,
+# that already holds `written` bits, and advances `written`
+fun write_bits(Int value, Int bits, Vector<Byte> output, Int written):
+    while bits > 0:
+        let offset = written % 8
+        if offset == 0:
+            output.append(byte(0))
+        let available = 8 - offset
+        if available > bits:
+            available = bits
+        let part = (value & ((1 << available) - 1)) << offset
+        let last = output.size() - 1
+        output.set(last, byte(int(output.get(last)) | part))
+        value = value >> available
+        bits = bits - available
+        written = written + available
+
+# reads `bits` bits starting from the bit `read` of
+# `input` into `result`, and advances `read`.
+# Returns false if `input` is too short.
+fun read_bits(Int result, Int bits, Vector<Byte> input, Int read) -> Bool:
+    if read < 0 or bits > input.size() * 8 - read:
+        return false
+    result = 0
+    let done = 0
+    while done < bits:
+        let offset = read % 8
+        let available = 8 - offset
+        if available > bits - done:
+            available = bits - done
+        let part = (int(input.get(read / 8)) >> offset) & ((1 << available) - 1)
+        result = result | (part << done)
+        done = done + available
+        read = read + available
+    return true
+
+# Trait that must be implemented by a type
+# to override the standard way it is packed
+# into a vector of bytes
+trait<T> PackedByteVectorSerializable:
+    fun append_to_packed_vector(T to_add, Vector<Byte> output, Int written)
+
+fun append_to_packed_vector(Int to_add, Vector<Byte> output, Int written):
+    write_bits(to_add, 64, output, written)
+
+fun append_to_packed_vector(Float to_add, Vector<Byte> output, Int written):
+    let as_int = __builtin_from_array<Int>(__builtin_to_array(to_add))
+    write_bits(as_int, 64, output, written)
+
+fun append_to_packed_vector(Bool to_add, Vector<Byte> output, Int written):
+    write_bits(int(to_add), 1, output, written)
+
+fun append_to_packed_vector(Byte to_add, Vector<Byte> output, Int written):
+    write_bits(int(to_add), 8, output, written)
+
+fun<Enum T> append_to_packed_vector(T to_add, Vector<Byte> output, Int written):
+    write_bits(to_add.as_int(), bits_needed_for(to_add.max() + 1), output, written)
+
+fun<T> append_to_packed_vector(Vector<T> to_add, Vector<Byte> output, Int written):
+    write_bits(to_add.size(), 64, output, written)
+    let counter = 0
+    while counter < to_add.size():
+        _to_packed_vector_impl(to_add.get(counter), output, written)
+        counter = counter + 1
+
+# the size takes only the bits needed to
+# count up to `max_size`
+fun<T, Int max_size> append_to_packed_vector(BoundedVector<T, max_size> to_add, Vector<Byte> output, Int written):
+    write_bits(to_add.size(), bits_needed_for(max_size + 1), output, written)
+    let counter = 0
+    while counter < to_add.size():
+        _to_packed_vector_impl(to_add.get(counter), output, written)
+        counter = counter + 1
+
+fun<T, Int X> append_to_packed_vector(T[X] to_add, Vector<Byte> output, Int written):
+    let counter = 0
+    while counter < X:
+        _to_packed_vector_impl(to_add[counter], output, written)
+        counter = counter + 1
+
+fun<T> _to_packed_vector_impl(T to_add, Vector<Byte> output, Int written):
+    if to_add is PackedByteVectorSerializable:
+        to_add.append_to_packed_vector(output, written)
+    else if to_add is Alternative:
+        let alternatives = 0
+        for field of to_add:
+            alternatives = alternatives + 1
+        let counter = 0
+        for field of to_add:
+            using Type = type(field)
+            if to_add is Type:
+                write_bits(counter, bits_needed_for(alternatives), output, written)
+                _to_packed_vector_impl(to_add, output, written)
+            counter = counter + 1
+    else:
+        for field of to_add:
+            _to_packed_vector_impl(field, output, written)
+
+# converts `to_convert` to a sequence of bits and
+# adds it to `out`, that already holds `written` bits
+fun<T> append_to_packed_byte_vector(T to_convert, Vector<Byte> out, Int written):
+    _to_packed_vector_impl(to_convert, out, written)
+
+# converts `to_convert` to a sequence of bits
+# packed into bytes
+fun<T> as_packed_byte_vector(T to_convert) -> Vector<Byte>:
+    let vec : Vector<Byte>
+    let written = 0
+    _to_packed_vector_impl(to_convert, vec, written)
+    return vec
+
+# Trait that can be implemented to override the default
+# unpacking of a object from a vector of bytes.
+# It must be implemented if the type has implemented
+# PackedByteVectorSerializable
+trait<T> PackedByteVectorParsable:
+    fun parse_from_packed_vector(T result, Vector<Byte> input, Int read) -> Bool
+
+fun parse_from_packed_vector(Int result, Vector<Byte> input, Int read) -> Bool:
+    return read_bits(result, 64, input, read)
+
+fun parse_from_packed_vector(Float result, Vector<Byte> input, Int read) -> Bool:
+    let as_int : Int
+    if !read_bits(as_int, 64, input, read):
+        return false
+    result = __builtin_from_array<Float>(__builtin_to_array(as_int))
+    return true
+
+fun parse_from_packed_vector(Bool result, Vector<Byte> input, Int read) -> Bool:
+    let value : Int
+    if !read_bits(value, 1, input, read):
+        return false
+    result = value == 1
+    return true
+
+fun parse_from_packed_vector(Byte result, Vector<Byte> input, Int read) -> Bool:
+    let value : Int
+    if !read_bits(value, 8, input, read):
+        return false
+    result = byte(value)
+    return true
+
+fun<Enum X> parse_from_packed_vector(X to_add, Vector<Byte> input, Int read) -> Bool:
+    let value = 0
+    let success = read_bits(value, bits_needed_for(to_add.max() + 1), input, read)
+    if success:
+        value = value % (to_add.max() + 1)
+    to_add.from_int(value)
+    return success
+
+fun<T> parse_from_packed_vector(Vector<T> output, Vector<Byte> input, Int read) -> Bool:
+    let size : Int
+    if !read_bits(size, 64, input, read):
+        return false
+    let counter = 0
+    while counter < size:
+        let raw : T
+        if !_from_packed_vector_impl(raw, input, read):
+            return false
+        output.append(raw)
+        counter = counter + 1
+    return true
+
+fun<T, Int max_size> parse_from_packed_vector(BoundedVector<T, max_size> output, Vector<Byte> input, Int read) -> Bool:
+    let size : Int
+    if !read_bits(size, bits_needed_for(max_size + 1), input, read):
+        return false
+    if size > max_size:
+        return false
+    output.clear()
+    let counter = 0
+    while counter < size:
+        let raw : T
+        if !_from_packed_vector_impl(raw, input, read):
+            return false
+        output.append(raw)
+        counter = counter + 1
+    return true
+
+fun<T, Int X> parse_from_packed_vector(T[X] to_add, Vector<Byte> input, Int read) -> Bool:
+    let counter = 0
+    while counter < X:
+        if !_from_packed_vector_impl(to_add[counter], input, read):
+            return false
+        counter = counter + 1
+    return true
+
+fun<T> _from_packed_vector_impl(T to_add, Vector<Byte> input, Int read) -> Bool:
+    if to_add is PackedByteVectorParsable:
+        return to_add.parse_from_packed_vector(input, read)
+    else if to_add is Alternative:
+        let alternatives = 0
+        for field of to_add:
+            alternatives = alternatives + 1
+        let counter = 0
+        if !read_bits(counter, bits_needed_for(alternatives), input, read):
+            return false
+        for field of to_add:
+            if counter == 0:
+                using Type = type(field)
+                let to_parse : Type
+                if !_from_packed_vector_impl(to_parse, input, read):
+                    return false
+                to_add = to_parse
+                return true
+            counter = counter - 1
+        return false
+    else:
+        for field of to_add:
+            if !_from_packed_vector_impl(field, input, read):
+                return false
+        return true
+
+# converts the bits packed in `input` into a T and
+# assigns the value to `result`. Returns false if the conversion failed.
+fun<T> from_packed_byte_vector(T result, Vector<Byte> input) -> Bool:
+    let read = 0
+    return _from_packed_vector_impl(result, input, read)
+
+# converts the bits packed in `input` starting at the bit `read`
+# into a T and assigns the value to `result`. Returns false if the
+# conversion failed. `read` is advanced up to the index of the first
+# bit not used to parse `result`
+fun<T> from_packed_byte_vector(T result, Vector<Byte> input, Int read) -> Bool:
+    return _from_packed_vector_impl(result, input, read)
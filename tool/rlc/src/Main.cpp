@@ -148,6 +148,17 @@ static cl::opt<std::string> clangPath(
 		cl::init("clang"),
 		cl::cat(astDumperCategory));
 
+static cl::opt<std::string> moduleCache(
+		"module-cache",
+		cl::desc("directory where parsed files are cached, keyed by their "
+						 "content, so that they are not parsed again by later "
+						 "invocations. Only parsing, the cheaper part of the front "
+						 "end, is cached: type checking still runs over the whole "
+						 "program every time. Defaults to the RLC_MODULE_CACHE "
+						 "environment variable"),
+		cl::init(""),
+		cl::cat(astDumperCategory));
+
 static cl::opt<std::string> abortSymbol(
 		"abort-symbol",
 		cl::desc("abort symbol called by assertions"),
@@ -248,6 +259,14 @@ static cl::opt<bool> dumpMLIR(
 		cl::init(false),
 		cl::cat(astDumperCategory));
 
+static cl::opt<bool> jit(
+		"jit",
+		cl::desc("compiles the program in memory and runs it, without emitting "
+						 "or linking any file. The exit code is the one returned by "
+						 "main"),
+		cl::init(false),
+		cl::cat(astDumperCategory));
+
 static cl::opt<bool> shared(
 		"shared",
 		cl::desc("compile as shared lib"),
@@ -262,6 +281,20 @@ static cl::opt<bool> verbose(
 
 static cl::alias v1("v", cl::aliasopt(verbose));
 
+static cl::opt<bool> disableThreading(
+		"no-threads",
+		cl::desc("run the compiler passes on a single thread"),
+		cl::init(false),
+		cl::cat(astDumperCategory));
+
+static cl::opt<unsigned> jobs(
+		"jobs",
+		cl::desc("splits the optimized module in this many partitions and "
+						 "generates their code in parallel, 0 uses all cores"),
+		cl::init(1),
+		cl::cat(astDumperCategory));
+static cl::alias j1("j", cl::aliasopt(jobs));
+
 static cl::opt<bool> dumpIR(
 		"ir",
 		cl::desc("dumps the llvm-ir and exits"),
@@ -283,6 +316,36 @@ static cl::opt<bool> emitBoundChecks(
 		cl::init(true),
 		cl::cat(astDumperCategory));
 
+static cl::opt<bool> incrementalHash(
+		"incremental-hash",
+		cl::desc("keep a zobrist hash in each action frame, updated on every "
+						 "store to its fields, and emit hash(Frame) reading it"),
+		cl::init(false),
+		cl::cat(astDumperCategory));
+
+static cl::opt<bool> undoLog(
+		"undo-log",
+		cl::desc("emit a FrameUndoLog class for each action frame, with "
+						 "record_undo(Frame, FrameUndoLog) and undo(Frame, FrameUndoLog) "
+						 "to revert actions in place"),
+		cl::init(false),
+		cl::cat(astDumperCategory));
+
+static cl::opt<bool> incrementalObservation(
+		"incremental-observation",
+		cl::desc("track which fields of each action frame are written and emit "
+						 "update_observation_tensor(Frame, Int, Vector<Float>) "
+						 "rewriting only their regions of the tensor"),
+		cl::init(false),
+		cl::cat(astDumperCategory));
+
+static cl::opt<bool> pruneActionEnumeration(
+		"prune-action-enumeration",
+		cl::desc("drop from enumerate(AnyXAction) the actions whose bounded "
+						 "arguments can never satisfy their preconditions"),
+		cl::init(false),
+		cl::cat(astDumperCategory));
+
 static cl::opt<bool> Optimize(
 		"O2",
 		cl::desc("Optimize"),
@@ -334,6 +397,29 @@ static cl::opt<std::string> customRuntime(
 		cl::init(""),
 		cl::cat(astDumperCategory));
 
+static cl::opt<bool> runtimeBitcode(
+		"runtime-bitcode",
+		cl::desc("when optimizing, links the bitcode of the runtime into the "
+						 "program instead of its library, so that its functions can be "
+						 "inlined"),
+		cl::init(true),
+		cl::cat(astDumperCategory));
+
+static cl::opt<std::string> pgoGen(
+		"pgo-gen",
+		cl::desc("instruments the program so that running it writes a execution "
+						 "profile, to the given file or to default_%m.profraw. Merge "
+						 "them with llvm-profdata and pass the result to --pgo-use"),
+		cl::ValueOptional,
+		cl::init(""),
+		cl::cat(astDumperCategory));
+
+static cl::opt<std::string> pgoUse(
+		"pgo-use",
+		cl::desc("optimizes the program using a profile written by llvm-profdata"),
+		cl::init(""),
+		cl::cat(astDumperCategory));
+
 static cl::opt<bool> sanitize(
 		"sanitize",
 		cl::desc("emit the sanitizer instrumentation"),
@@ -400,6 +486,8 @@ static mlir::rlc::Driver::Request getRequest()
 		return Driver::Request::dumpMLIR;
 	if (compileOnly)
 		return Driver::Request::compile;
+	if (jit)
+		return Driver::Request::jit;
 	if (dumpBeforeTemplate)
 		return Driver::Request::dumpBeforeTemplate;
 	if (formatFile)
@@ -417,6 +505,9 @@ static std::string toNative(llvm::StringRef path)
 	return out;
 }
 
+// value returned by main when the program is run with --jit
+static int jitExitCode = 0;
+
 static mlir::rlc::Driver configureDriver(
 		char *argv[],
 		llvm::SourceMgr &srcManager,
@@ -487,9 +578,35 @@ static mlir::rlc::Driver configureDriver(
 					RUNTIME_LIBRARY_FILENAME);
 	}
 
+	// the bitcode is built next to the runtime library, and is linked in its
+	// place. It is built for the host, and on windows the library carries the
+	// C runtime too, so it is only used when optimizing for the host.
+	auto runtimeBitcodePath = llvm::SmallString<128>(runtimeLibPath);
+	llvm::sys::path::replace_extension(runtimeBitcodePath, ".bc");
+	bool useRuntimeBitcode = runtimeBitcode and Optimize and not emitFuzzer and
+													 customTargetTriple == "" and not info.isWindows() and
+													 llvm::sys::fs::exists(runtimeBitcodePath);
+
+	// the library is passed even when the bitcode is used: once the bitcode is
+	// linked in, the library defines nothing the program still needs, so the
+	// linker only pulls it in if the backend had to drop the bitcode.
 	if (not emitFuzzer)
 		objectFiles.push_back(runtimeLibPath);
 
+	string moduleCachePath = moduleCache;
+	auto moduleCacheEnv = llvm::sys::Process::GetEnv("RLC_MODULE_CACHE");
+	if (moduleCachePath.empty() and moduleCacheEnv.has_value())
+		moduleCachePath = *moduleCacheEnv;
+
+	// cached files are only valid for the compiler that wrote them
+	string moduleCacheSalt = pathToRlc;
+	llvm::sys::fs::file_status rlcStatus;
+	if (not llvm::sys::fs::status(pathToRlc, rlcStatus))
+		moduleCacheSalt += ":" + std::to_string(rlcStatus.getSize()) + ":" +
+											 std::to_string(rlcStatus.getLastModificationTime()
+																					.time_since_epoch()
+																					.count());
+
 	Driver driver(srcManager, inputs, outputFile, OS);
 	driver.setRequest(getRequest());
 	driver.setDebug(debugInfo);
@@ -498,6 +615,10 @@ static mlir::rlc::Driver configureDriver(
 	driver.setEmitPreconditionChecks(emitPreconditionChecks);
 	driver.setDumpIR(dumpIR);
 	driver.setClangPath(clangPath);
+	if (useRuntimeBitcode)
+		driver.setRuntimeBitcode(runtimeBitcodePath.str().str());
+	if (not moduleCachePath.empty())
+		driver.setModuleCache(toNative(moduleCachePath), moduleCacheSalt);
 	driver.setIncludeDirs(includes);
 	driver.setExtraObjectFile(objectFiles);
 	driver.setRPath(RPath);
@@ -506,7 +627,15 @@ static mlir::rlc::Driver configureDriver(
 	driver.setTargetInfo(&info);
 	driver.setKeepComments(!dropComments);
 	driver.setEmitBoundChecks(emitBoundChecks);
+	driver.setPruneActionEnumeration(pruneActionEnumeration);
+	driver.setIncrementalHash(incrementalHash);
+	driver.setUndoLog(undoLog);
+	driver.setIncrementalObservation(incrementalObservation);
 	driver.setVerbose(verbose);
+	driver.setJobs(jobs);
+	driver.setJitExitCode(&jitExitCode);
+	driver.setPGOGen(pgoGen.getNumOccurrences() != 0, pgoGen);
+	driver.setPGOUse(pgoUse);
 	driver.setAbortSymbol(abortSymbol);
 	driver.setHideStandardLibFiles(hideStandardLibFiles);
 	driver.setGraphInlineCalls(graphInlineCalls);
@@ -549,6 +678,8 @@ static int run(
 		}
 		return -1;
 	}
+	if (getRequest() == mlir::rlc::Driver::Request::jit)
+		return jitExitCode;
 	return 0;
 }
 
@@ -569,7 +700,9 @@ int main(int argc, char *argv[])
 	mlir::rlc::initLLVM();
 	mlir::registerAllTranslations();
 
-	mlir::MLIRContext context(mlir::MLIRContext::Threading::DISABLED);
+	mlir::MLIRContext context(
+			disableThreading ? mlir::MLIRContext::Threading::DISABLED
+											 : mlir::MLIRContext::Threading::ENABLED);
 	llvm::SourceMgr sourceManager;
 	mlir::SourceMgrDiagnosticHandler diagnostic(
 			sourceManager, &context, [](mlir::Location) { return true; });
@@ -590,6 +723,17 @@ int main(int argc, char *argv[])
 	context.appendDialectRegistry(Registry);
 	context.loadAllAvailableDialects();
 
+	if (pgoGen.getNumOccurrences() != 0 and pgoUse != "")
+	{
+		errs() << "--pgo-gen and --pgo-use can't be used together\n";
+		return errorCode(-1);
+	}
+	if (pgoUse != "" and not llvm::sys::fs::exists(pgoUse))
+	{
+		errs() << "could not find profile " << pgoUse << "\n";
+		return errorCode(-1);
+	}
+
 	if (outputFile == "-" and
 			(getRequest() == mlir::rlc::Driver::Request::executable or
 			 getRequest() == mlir::rlc::Driver::Request::compile) and
@@ -0,0 +1,52 @@
+# RUN: rlc %s -o %t -i %stdlib --sanitize
+# RUN: %t%exeext
+
+import serialization.to_byte_vector
+import serialization.to_hash
+import serialization.key_equal
+
+cls Hand:
+  BoundedVector<Vector<Int>, 4> cards
+
+fun main() -> Int:
+  let hand : Hand
+  let card : Vector<Int>
+  let i = 0
+  while i < 6:
+    card.append(i)
+    hand.cards.append(card)
+    i = i + 1
+  if hand.cards.size() != 4 or hand.cards.get(3).size() != 4:
+    return 1
+
+  hand.cards.erase(0)
+  if hand.cards.size() != 3 or hand.cards.get(0).size() != 2:
+    return 2
+
+  # copies are deep, and do not share the elements
+  let copy = hand
+  copy.cards.get(0).append(9)
+  if hand.cards.get(0).size() != 2:
+    return 3
+
+  # the serialization and the hash ignore the unused slots
+  copy.cards.pop()
+  copy.cards.get(0).pop()
+  hand.cards.pop()
+  if !compute_equal_of(copy.cards, hand.cards):
+    return 4
+  if compute_hash_of(copy.cards) != compute_hash_of(hand.cards):
+    return 5
+
+  let bytes = as_byte_vector(hand)
+  let parsed : Hand
+  parsed.cards.resize(4)
+  if !from_byte_vector(parsed, bytes):
+    return 6
+  if parsed.cards.size() != 2 or parsed.cards.get(1).get(2) != 2:
+    return 7
+
+  parsed.cards.resize(10)
+  if parsed.cards.size() != 4 or parsed.cards.get(3).size() != 0:
+    return 8
+  return 0
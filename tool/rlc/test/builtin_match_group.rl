@@ -0,0 +1,20 @@
+# RUN: rlc %s -o %t -i %stdlib
+# RUN: %t%exeext
+
+fun main() -> Int:
+  let control = __builtin_malloc_do_not_use<Byte>(32)
+  let i = 0
+  while i < 32:
+    control[i] = byte(i % 4)
+    i = i + 1
+  control[17] = byte(-128)
+
+  let result = 0
+  if __builtin_match_group_do_not_use(control, 0, byte(1)) != 8738:
+    result = 1
+  else if __builtin_match_group_do_not_use(control, 16, byte(-128)) != 2:
+    result = 2
+  else if __builtin_match_group_do_not_use(control, 3, byte(7)) != 0:
+    result = 3
+  __builtin_free_do_not_use(control)
+  return result
@@ -0,0 +1,52 @@
+# RUN: rlc %s -o %t -i %stdlib --sanitize
+# RUN: %t%exeext
+
+import collections.dictionary
+
+fun main() -> Int:
+  let x : Dict<Int, Int>
+  let i = 0
+  while i < 1000:
+    x.insert(i, i * 2)
+    i = i + 1
+  if x.size() != 1000:
+    return 1
+
+  # leaves deleted slots behind, which must be reused and skipped
+  i = 0
+  while i < 1000:
+    if !x.remove(i):
+      return 2
+    i = i + 2
+  if x.size() != 500 or x.remove(0):
+    return 3
+
+  i = 0
+  while i < 1000:
+    if x.contains(i) != (i % 2 == 1):
+      return 4
+    i = i + 1
+
+  i = 0
+  while i < 1000:
+    x.insert(i, i * 3)
+    i = i + 2
+  i = 0
+  while i < 1000:
+    let expected = i * 2
+    if i % 2 == 0:
+      expected = i * 3
+    if x.get(i) != expected:
+      return 5
+    i = i + 1
+
+  let keys = x.keys()
+  if keys.size() != 1000:
+    return 6
+  x.clear()
+  if x.contains(1) or !x.empty():
+    return 7
+  x.insert(1, 1)
+  if x.get(1) != 1:
+    return 8
+  return 0
@@ -0,0 +1,40 @@
+# RUN: rlc %s -o %t -i %stdlib
+# RUN: %t%exeext
+
+import action
+
+@classes
+act play() -> Game:
+  act first(BInt<0, 3> x) {x.value != 1}
+  act second(BInt<0, 3> y) {y.value == 2}
+
+fun main() -> Int:
+  let states : Vector<Game>
+  states.append(play())
+  states.append(play())
+  let arg : BInt<0, 3>
+  states.get(1).first(arg)
+
+  let any_action : AnyGameAction
+  let actions = enumerate(any_action)
+  let mask : Vector<Byte>
+  get_valid_actions_batch(states, actions, mask)
+  if mask.size() != 2 * actions.size():
+    return 1
+
+  let expected : Vector<Byte>
+  let i = 0
+  while i != actions.size():
+    expected.append(byte(0))
+    i = i + 1
+
+  let row = 0
+  while row != states.size():
+    get_valid_actions(expected, actions, states.get(row))
+    let column = 0
+    while column != actions.size():
+      if mask[row * actions.size() + column] != expected[column]:
+        return 2 + row
+      column = column + 1
+    row = row + 1
+  return 0
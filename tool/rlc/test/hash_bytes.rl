@@ -0,0 +1,53 @@
+# RUN: rlc %s -o %t -i %stdlib
+# RUN: %t%exeext
+
+import serialization.to_hash
+import string
+
+cls Plain:
+  Int x
+  Int[3] y
+
+cls Padded:
+  Bool x
+  Int y
+
+fun main() -> Int:
+  let plain : Plain
+  let padded : Padded
+  let floating = 1.0
+  let vector : Vector<Int>
+  if !__builtin_is_plain_data_do_not_use(plain):
+    return 1
+  if __builtin_is_plain_data_do_not_use(padded) or __builtin_is_plain_data_do_not_use(floating) or __builtin_is_plain_data_do_not_use(vector):
+    return 2
+
+  let other : Plain
+  plain.y[2] = 4
+  other.y[2] = 4
+  if compute_hash_of(plain) != compute_hash_of(other):
+    return 3
+  other.x = 1
+  if compute_hash_of(plain) == compute_hash_of(other):
+    return 4
+
+  let s1 = "a long enough string to go through the wide loop of the hash"s
+  let s2 = "a long enough string to go through the wide loop of the hash"s
+  if compute_hash_of(s1) != compute_hash_of(s2):
+    return 5
+  s2.append('!')
+  if compute_hash_of(s1) == compute_hash_of(s2):
+    return 6
+
+  let zero = 0.0
+  if compute_hash_of(zero) != compute_hash_of(-zero):
+    return 7
+
+  vector.append(3)
+  let vector2 = vector
+  if compute_hash_of(vector) != compute_hash_of(vector2):
+    return 8
+  vector2.append(0)
+  if compute_hash_of(vector) == compute_hash_of(vector2):
+    return 9
+  return 0
@@ -0,0 +1,47 @@
+# RUN: rlc %s -o %t -i %stdlib --incremental-hash
+# RUN: %t%exeext
+
+import serialization.to_hash
+
+act play() -> Game:
+  frm x = 0
+  frm y = 0
+  frm flipped = false
+  frm history : Int[2]
+  while x + y < 10:
+    actions:
+      act add_x(Int dx)
+      x = x + dx
+      act add_y(Int dy)
+      y = y + dy
+      flipped = !flipped
+      history[0] = y
+
+fun main() -> Int:
+  let a = play()
+  let b = play()
+  if hash(a) != hash(b):
+    return 1
+
+  # the same state reached in a different order has the same hash
+  a.add_x(1)
+  a.add_y(2)
+  b.add_y(2)
+  b.add_x(1)
+  if hash(a) != hash(b):
+    return 2
+
+  let before = hash(a)
+  a.add_x(1)
+  if hash(a) == before:
+    return 3
+
+  # stores performed outside of the action are seen too
+  a.x = a.x - 1
+  if hash(a) != before:
+    return 4
+
+  let copy = a
+  if hash(copy) != hash(a):
+    return 5
+  return 0
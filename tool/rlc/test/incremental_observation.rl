@@ -0,0 +1,66 @@
+# RUN: rlc %s -o %t -i %stdlib --incremental-observation
+# RUN: %t%exeext
+
+import action
+
+act play() -> Game:
+  frm score : BInt<0, 4>
+  frm board : Bool[9]
+  frm turn = false
+  while score.value < 3:
+    actions:
+      act mark(BInt<0, 9> cell)
+      board[cell.value] = true
+      turn = !turn
+      act bump()
+      score.value = score.value + 1
+
+fun same(Vector<Float> a, Vector<Float> b) -> Bool:
+  if a.size() != b.size():
+    return false
+  let counter = 0
+  while counter != a.size():
+    if a.get(counter) != b.get(counter):
+      return false
+    counter = counter + 1
+  return true
+
+fun main() -> Int:
+  let game = play()
+  let tensor : Vector<Float>
+  tensor.resize(observation_tensor_size(game))
+  update_observation_tensor(game, 0, tensor)
+  # score takes the slots 0 to 3, board 4 to 12 and turn 13
+  if tensor.get(0) != 1.0 or tensor.get(12) != 0.0:
+    return 1
+
+  # the regions of the fields no one wrote are left untouched
+  tensor.get(12) = 5.0
+  game.bump()
+  update_observation_tensor(game, 0, tensor)
+  if tensor.get(12) != 5.0 or tensor.get(0) != 0.0 or tensor.get(1) != 1.0:
+    return 2
+
+  let cell : BInt<0, 9>
+  cell.value = 8
+  game.mark(cell)
+  update_observation_tensor(game, 0, tensor)
+  if tensor.get(12) != 1.0 or tensor.get(13) != 1.0:
+    return 3
+  if !same(tensor, to_observation_tensor(game, 0)):
+    return 4
+
+  # stores performed outside of the actions are seen too
+  game.turn = false
+  update_observation_tensor(game, 0, tensor)
+  if !same(tensor, to_observation_tensor(game, 0)):
+    return 5
+
+  # copies rewrite the whole tensor the first time
+  let copy = game
+  let copy_tensor : Vector<Float>
+  copy_tensor.resize(observation_tensor_size(copy))
+  update_observation_tensor(copy, 0, copy_tensor)
+  if !same(copy_tensor, tensor):
+    return 6
+  return 0
@@ -0,0 +1,15 @@
+# RUN: rlc %s -i %stdlib --jit
+# RUN: rlc %s -i %stdlib --jit -O2
+
+import collections.vector
+import string
+import serialization.print
+
+fun main() -> Int:
+  let vector : Vector<Int>
+  vector.append(1)
+  vector.append(2)
+  # formatting the integer goes through the runtime
+  if to_string(vector) != "[1, 2]":
+    return 1
+  return 0
@@ -0,0 +1,54 @@
+# RUN: rlc %s -o %t -i %stdlib
+# RUN: %t%exeext
+
+import action
+
+@classes
+act play() -> Game:
+  frm limit = 0
+  act first(BInt<0, 4> x) {x.value != 1}
+  limit = x.value
+  while limit != 0:
+    actions:
+      act second(BInt<0, 4> y, Bool b) {y.value < limit, b}
+      limit = y.value
+      act first(BInt<0, 4> x) {x.value == limit}
+
+fun check(Game state, Vector<AnyGameAction> actions) -> Bool:
+  let mask : Vector<Byte>
+  let i = 0
+  while i != actions.size():
+    mask.append(byte(2))
+    i = i + 1
+  get_valid_actions(mask, actions, state)
+
+  let j = 0
+  for action in actions:
+    let expected = byte(0)
+    if can apply(action, state):
+      expected = byte(1)
+    if mask[j] != expected:
+      return false
+    j = j + 1
+  return true
+
+fun main() -> Int:
+  let any_action : AnyGameAction
+  let actions = enumerate(any_action)
+
+  let state = play()
+  if !check(state, actions):
+    return 1
+
+  let x : BInt<0, 4>
+  x.value = 3
+  state.first(x)
+  if !check(state, actions):
+    return 2
+
+  let y : BInt<0, 4>
+  y.value = 2
+  state.second(y, true)
+  if !check(state, actions):
+    return 3
+  return 0
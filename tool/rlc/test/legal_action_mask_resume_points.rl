@@ -0,0 +1,61 @@
+# RUN: rlc %s -o %t -i %stdlib
+# RUN: %t%exeext
+
+import action
+
+# first can be executed at two resumption points, and only the
+# second one has a precondition, so the mask must test both of them.
+# get_valid_actions forwards to the fused legal_action_mask.
+@classes
+act play() -> Game:
+  frm limit = 0
+  act first(BInt<0, 4> x)
+  limit = x.value
+  act second(BInt<0, 4> y) {y.value != limit}
+  act first(BInt<0, 4> x) {x.value < limit}
+
+fun check(Game state, Vector<AnyGameAction> actions) -> Bool:
+  let mask : Vector<Byte>
+  let i = 0
+  while i != actions.size():
+    mask.append(byte(2))
+    i = i + 1
+  get_valid_actions(mask, actions, state)
+
+  let j = 0
+  let legal = 0
+  for action in actions:
+    let expected = byte(0)
+    if can apply(action, state):
+      expected = byte(1)
+      legal = legal + 1
+    if mask[j] != expected:
+      return false
+    j = j + 1
+  return legal != 0 or state.is_done()
+
+fun main() -> Int:
+  let any_action : AnyGameAction
+  let actions = enumerate(any_action)
+
+  let state = play()
+  if !check(state, actions):
+    return 1
+
+  let x : BInt<0, 4>
+  x.value = 3
+  state.first(x)
+  if !check(state, actions):
+    return 2
+
+  let y : BInt<0, 4>
+  y.value = 0
+  state.second(y)
+  if !check(state, actions):
+    return 3
+
+  x.value = 2
+  state.first(x)
+  if !state.is_done() or !check(state, actions):
+    return 4
+  return 0
@@ -47,6 +47,10 @@ tools = ["clang", "rlc", "rlc-opt"]
 if shutil.which('mcs') and shutil.which('mono'):
     config.available_features.add('has_mono')
 
+if shutil.which('llvm-profdata', path=config.llvm_tools_dir) or shutil.which('llvm-profdata'):
+    config.available_features.add('has_llvm_profdata')
+    tools.append('llvm-profdata')
+
 llvm_config.add_tool_substitutions(tools, tool_dirs)
 
 # Set the LD_LIBRARY_PATH
@@ -0,0 +1,99 @@
+# RUN: rlc %s -o %t -i %stdlib --sanitize
+# RUN: %t%exeext
+
+import serialization.to_byte_vector
+import bounded_arg
+
+cls Plain:
+  Int a
+  Float b
+  Int[3] c
+
+cls Padded:
+  Int a
+  Bool b
+
+cls Compact:
+  Int a
+  BInt<0, 10> b
+
+fun main() -> Int:
+  let plain : Plain
+  let padded : Padded
+  let compact : Compact
+  if __builtin_size_of_do_not_use(0) != 8 or __builtin_size_of_do_not_use(plain) != 40:
+    return 1
+  if !_is_memory_serializable(plain) or _is_memory_serializable(padded) or _is_memory_serializable(compact):
+    return 2
+
+  # the bytes are the same that would be written one at the time
+  plain.a = 258
+  plain.b = 1.0
+  plain.c[2] = -1
+  let bytes = as_byte_vector(plain)
+  if bytes.size() != 40 or bytes.get(0) != byte(2) or bytes.get(1) != byte(1) or bytes.get(2) != byte(0):
+    return 3
+  let float_bytes = __builtin_to_array(1.0)
+  if bytes.get(15) != float_bytes[7] or bytes.get(39) != byte(-1) or bytes.get(31) != byte(0):
+    return 4
+  let parsed : Plain
+  if !from_byte_vector(parsed, bytes) or parsed.a != 258 or parsed.b != 1.0 or parsed.c[2] != -1:
+    return 5
+
+  # inputs too short are rejected
+  bytes.pop()
+  if from_byte_vector(parsed, bytes):
+    return 6
+
+  # padding and custom serializations are written field by field
+  padded.a = 3
+  padded.b = true
+  let padded_bytes = as_byte_vector(padded)
+  if padded_bytes.size() != 9:
+    return 7
+  compact.b.value = 4
+  if as_byte_vector(compact).size() != 9:
+    return 8
+
+  # vectors keep the size prefix, and parsing appends to the output
+  let vector : Vector<Int>
+  let counter = 0
+  while counter != 100:
+    vector.append(counter)
+    counter = counter + 1
+  let vector_bytes = as_byte_vector(vector)
+  if vector_bytes.size() != 808:
+    return 9
+  let parsed_vector : Vector<Int>
+  parsed_vector.append(-5)
+  if !from_byte_vector(parsed_vector, vector_bytes) or parsed_vector.size() != 101:
+    return 10
+  if parsed_vector.get(0) != -5 or parsed_vector.get(100) != 99:
+    return 11
+
+  # a size larger than the input is rejected before allocating
+  let huge = as_byte_vector(4611686018427387904)
+  let rejected : Vector<Int>
+  if from_byte_vector(rejected, huge) or rejected.size() != 0:
+    return 12
+
+  let bounded : BoundedVector<Byte, 8>
+  bounded.append(byte(7))
+  bounded.append(byte(9))
+  let bounded_bytes = as_byte_vector(bounded)
+  if bounded_bytes.size() != 10:
+    return 13
+  let parsed_bounded : BoundedVector<Byte, 8>
+  if !from_byte_vector(parsed_bounded, bounded_bytes) or parsed_bounded.size() != 2 or parsed_bounded.get(1) != byte(9):
+    return 14
+
+  # parsing with a offset advances it past the read bytes
+  let both = as_byte_vector(plain)
+  append_to_byte_vector(vector, both)
+  let read = 0
+  if !from_byte_vector(parsed, both, read) or read != 40:
+    return 15
+  let second : Vector<Int>
+  if !from_byte_vector(second, both, read) or read != both.size() or second.get(50) != 50:
+    return 16
+  return 0
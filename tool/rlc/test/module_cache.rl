@@ -0,0 +1,22 @@
+# RUN: rm -rf %t.cache
+# RUN: rlc %s -o %t -i %stdlib --module-cache %t.cache -v 2>&1 | FileCheck %s --check-prefix=COLD
+# RUN: ls %t.cache | FileCheck %s --check-prefix=ENTRIES
+# RUN: rlc %s -o %t -i %stdlib --module-cache %t.cache -v 2>&1 | FileCheck %s --check-prefix=WARM
+# RUN: %t%exeext
+# RUN: rlc %s -i %stdlib --unchecked > %t.uncached
+# RUN: rlc %s -i %stdlib --unchecked --module-cache %t.cache > %t.cached
+# RUN: diff %t.uncached %t.cached
+
+# COLD: module cache: 0 hits, {{[1-9][0-9]*}} misses
+# ENTRIES: {{[0-9A-F]+}}.mlirbc
+# WARM: module cache: {{[1-9][0-9]*}} hits, 0 misses
+
+import collections.vector
+
+fun main() -> Int:
+  let vector : Vector<Int>
+  vector.append(3)
+  vector.append(4)
+  if vector.size() != 2:
+    return 1
+  return vector.get(1) - 4
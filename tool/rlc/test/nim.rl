@@ -0,0 +1,60 @@
+# RUN: rlc %s -o %t -i %stdlib --incremental-hash
+# RUN: %t%exeext
+
+import serialization.to_hash
+import string
+import action
+
+# nim with a single pile of seven stones: players take turns
+# removing one to three stones, and who takes the last one wins.
+# The first player wins by taking three stones, and then always
+# leaving a multiple of four of them to the other player.
+@classes
+act play() -> Game:
+  frm stones : BInt<0, 8>
+  frm player_turn = false
+  stones.value = 7
+  while stones.value != 0:
+    act take(BInt<1, 4> count) { count.value <= stones.value }
+    stones.value = stones.value - count.value
+    if stones.value != 0:
+      player_turn = !player_turn
+
+fun remaining_stones(Game g) -> Int:
+  return g.stones.value
+
+fun get_current_player(Game g) -> Int:
+  return int(g.player_turn)
+
+# once the game is over, the player that would be
+# playing is the one that took the last stone
+fun score(Game g, Int player_id) -> Float:
+  if !g.is_done():
+    return 0.0
+  if get_current_player(g) == player_id:
+    return 1.0
+  return -1.0
+
+fun get_num_players() -> Int:
+  return 2
+
+fun max_game_lenght() -> Int:
+  return 7
+
+fun pretty_print(Game g):
+  print(to_string(g.stones.value))
+
+fun main() -> Int:
+  let game = play()
+  let count : BInt<1, 4>
+  count.value = 3
+  game.take(count)
+  if remaining_stones(game) != 4 or get_current_player(game) != 1:
+    return 1
+  count.value = 1
+  game.take(count)
+  count.value = 3
+  game.take(count)
+  if !game.is_done() or score(game, 0) != 1.0 or score(game, 1) != -1.0:
+    return 2
+  return 0
@@ -0,0 +1,76 @@
+# RUN: rlc %s -o %t -i %stdlib --sanitize
+# RUN: %t%exeext
+
+import serialization.to_packed_byte_vector
+import serialization.to_byte_vector
+import bounded_arg
+
+enum Color:
+  red
+  green
+  blue
+
+cls Small:
+  Bool a
+  BInt<0, 10> b
+  Color color
+  Bool c
+
+cls Snapshot:
+  Small[3] smalls
+  BoundedVector<LinearlyDistributedInt<0, 10>, 4> history
+  Int turn
+  Float score
+  Vector<Byte> log
+
+fun main() -> Int:
+  if bits_needed_for(1) != 0 or bits_needed_for(2) != 1 or bits_needed_for(10) != 4 or bits_needed_for(16) != 4:
+    return 1
+
+  # 1 + 4 + 2 + 1 bits, lowest bit first
+  let small : Small
+  small.a = true
+  small.b = 7
+  small.color = Color::blue
+  small.c = true
+  let bytes = as_packed_byte_vector(small)
+  if bytes.size() != 1 or bytes.get(0) != byte(207):
+    return 2
+  let parsed_small : Small
+  if !from_packed_byte_vector(parsed_small, bytes):
+    return 3
+  if !parsed_small.a or parsed_small.b != 7 or parsed_small.color != Color::blue or !parsed_small.c:
+    return 4
+
+  let snapshot : Snapshot
+  snapshot.smalls[1] = small
+  let entry : LinearlyDistributedInt<0, 10>
+  snapshot.history.append(entry)
+  entry = 9
+  snapshot.history.append(entry)
+  snapshot.turn = -3
+  snapshot.score = 2.5
+  snapshot.log.append(byte(-1))
+  let packed = as_packed_byte_vector(snapshot)
+  # 24 + 3 + 2 * 4 + 64 + 64 + 64 + 8 bits
+  if packed.size() != 30:
+    return 5
+  if packed.size() * 2 > as_byte_vector(snapshot).size():
+    return 6
+
+  let parsed : Snapshot
+  let read = 0
+  if !from_packed_byte_vector(parsed, packed, read) or read != 235:
+    return 7
+  if !parsed.smalls[1].c or parsed.smalls[1].color != Color::blue or parsed.smalls[0].a:
+    return 8
+  if parsed.history.size() != 2 or parsed.history.get(0) != 0 or parsed.history.get(1) != 9:
+    return 9
+  if parsed.turn != -3 or parsed.score != 2.5 or parsed.log.size() != 1 or parsed.log.get(0) != byte(-1):
+    return 10
+
+  # truncated inputs are rejected
+  packed.pop()
+  if from_packed_byte_vector(parsed, packed):
+    return 11
+  return 0
@@ -0,0 +1,18 @@
+# RUN: rlc %s -o %t -i %stdlib -O2 --jobs 4
+# RUN: %t%exeext
+
+import collections.vector
+
+fun sum(Vector<Int> values) -> Int:
+  let result = 0
+  for value in values:
+    result = result + value
+  return result
+
+fun main() -> Int:
+  let values : Vector<Int>
+  let counter = 0
+  while counter != 10:
+    values.append(counter)
+    counter = counter + 1
+  return sum(values) - 45
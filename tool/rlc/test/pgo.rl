@@ -0,0 +1,27 @@
+# REQUIRES: has_llvm_profdata
+# RUN: rm -f %t.profraw
+# RUN: rlc %s -o %t -i %stdlib -O2 --pgo-gen=%t.profraw
+# RUN: %t%exeext
+# RUN: llvm-profdata merge -o %t.profdata %t.profraw
+# RUN: rlc %s -o %t -i %stdlib -O2 --pgo-use %t.profdata
+# RUN: %t%exeext
+
+fun collatz(Int start) -> Int:
+  let steps = 0
+  let value = start
+  while value != 1:
+    if value % 2 == 0:
+      value = value / 2
+    else:
+      value = value * 3 + 1
+    steps = steps + 1
+  return steps
+
+fun main() -> Int:
+  let total = 0
+  let counter = 1
+  while counter != 10:
+    total = total + collatz(counter)
+    counter = counter + 1
+  # 0 + 1 + 7 + 2 + 5 + 8 + 16 + 3 + 19
+  return total - 61
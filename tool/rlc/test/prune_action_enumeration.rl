@@ -0,0 +1,33 @@
+# RUN: rlc %s -o %t -i %stdlib --prune-action-enumeration
+# RUN: %t%exeext
+
+import action
+
+@classes
+act play() -> Game:
+  frm total = 0
+  while total < 20:
+    actions:
+      act small(BInt<0, 10> x) {x.value < 3}
+      total = total + x.value
+      act large(BInt<0, 10> x, BInt<0, 10> y) {x > 6, y.value == 4 or y.value == 5}
+      total = total + x.value + y.value
+      act free(BInt<0, 10> x)
+      total = total + x.value
+
+fun main() -> Int:
+  let any_action : AnyGameAction
+  let actions = enumerate(any_action)
+  # small keeps 0..2, large keeps 7..9 x 4..5, free keeps all of them
+  if actions.size() != 3 + 3 * 2 + 10:
+    return 1
+
+  let state = play()
+  for action in actions:
+    if action is GameLarge:
+      if action.x.value < 7 or action.y.value < 4 or action.y.value > 5:
+        return 2
+    if action is GameSmall:
+      if !(can apply(action, state)):
+        return 3
+  return 0
@@ -0,0 +1,27 @@
+# RUN: rlc %s -o %t -i %stdlib -O2
+# RUN: %t%exeext
+# RUN: rlc %s -o %t -i %stdlib -O2 --runtime-bitcode=false
+# RUN: %t%exeext
+
+import string
+import math.numeric
+
+fun main() -> Int:
+  let text = "ab_1 "
+  let count = 0
+  let index = 0
+  while index != text.size():
+    if is_alphanumeric(text.get(index)):
+      count = count + 1
+    index = index + 1
+  if count != 3:
+    return 1
+
+  let parsed = 0
+  let position = 0
+  let buffer = "42"
+  if !parse_string(parsed, buffer, position) or parsed != 42:
+    return 2
+  if sqrt(16.0) != 4.0:
+    return 3
+  return 0
@@ -0,0 +1,55 @@
+# RUN: rlc %s -o %t -i %stdlib --sanitize
+# RUN: %t%exeext
+
+import action
+import machine_learning
+
+cls State:
+  Bool | BInt<0, 3> | Byte choice
+  BoundedVector<Bool, 3> history
+  HiddenInformation<BInt<0, 2>> secret
+  Bool last
+
+fun main() -> Int:
+  let state : State
+  # 3 tags + 256 slots of the byte, 3, 2 and 1
+  let size = observation_tensor_size(state)
+  if size != 265:
+    return 1
+
+  let tensor : Vector<Float>
+  let x = size
+  while x != 0:
+    tensor.append(0.0)
+    x = x - 1
+  state.choice = byte(-127)
+  state.history.append(true)
+  state.history.append(true)
+  state.secret.owner = 0
+  state.secret.value = 1
+  state.last = true
+  to_observation_tensor(state, 0, tensor)
+  if tensor.get(2) != 1.0 or tensor.get(4) != 1.0:
+    return 2
+  if tensor.get(259) != 1.0 or tensor.get(260) != 1.0 or tensor.get(263) != 1.0 or tensor.get(264) != 1.0:
+    return 3
+
+  # every field keeps its offset, and the slots
+  # that are not used anymore are cleared
+  let bounded : BInt<0, 3>
+  bounded.value = 2
+  state.choice = bounded
+  state.history.clear()
+  to_observation_tensor(state, 1, tensor)
+  if tensor.get(1) != 1.0 or tensor.get(5) != 1.0 or tensor.get(4) != 0.0:
+    return 4
+  if tensor.get(259) != 0.0 or tensor.get(260) != 0.0 or tensor.get(263) != 0.0 or tensor.get(264) != 1.0:
+    return 5
+  let counter = 0
+  let ones = 0
+  while counter != size:
+    ones = ones + int(tensor.get(counter))
+    counter = counter + 1
+  if ones != 3:
+    return 6
+  return 0
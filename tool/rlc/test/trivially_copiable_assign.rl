@@ -0,0 +1,71 @@
+# RUN: rlc %s -o %t -i %stdlib
+# RUN: %t%exeext
+
+import collections.vector
+
+cls Counter:
+  Int value
+
+  fun assign(Counter other):
+    self.value = other.value + 1
+
+cls Plain:
+  Int x
+  Bool[3] flags
+  Float f
+
+cls WithCustom:
+  Int x
+  Counter counter
+
+act play() -> Game:
+  frm plain : Plain
+  frm values : Vector<Int>
+  act step(Int x)
+  plain.x = x
+  plain.flags[1] = true
+  values.append(x)
+  values.append(x + 1)
+
+fun main() -> Int:
+  let a : Plain
+  a.x = 4
+  a.flags[2] = true
+  a.f = 1.5
+  let b = a
+  if b.x != 4 or !b.flags[2] or b.flags[0] or b.f != 1.5:
+    return 1
+
+  # types containing a custom assign must keep using it
+  let c : WithCustom
+  c.counter.value = 3
+  let d : WithCustom
+  d = c
+  if d.counter.value != 4:
+    return 2
+
+  let state = play()
+  state.step(3)
+  let copy = state
+  if copy.plain.x != 3 or !copy.plain.flags[1]:
+    return 3
+  if copy.values.size() != 2 or copy.values[1] != 4:
+    return 4
+
+  # copying a shorter vector over a longer one must shrink it
+  let long : Vector<Int>
+  let i = 0
+  while i != 10:
+    long.append(i)
+    i = i + 1
+  let short : Vector<Int>
+  short.append(42)
+  long = short
+  if long.size() != 1 or long[0] != 42:
+    return 5
+
+  # and a longer one over a shorter one must grow it
+  short = copy.values
+  if short.size() != 2 or short[0] != 3 or short[1] != 4:
+    return 6
+  return 0
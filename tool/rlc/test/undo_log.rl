@@ -0,0 +1,46 @@
+# RUN: rlc %s -o %t -i %stdlib --undo-log
+# RUN: %t%exeext
+
+cls Board:
+  Int[3] cells
+
+act play(frm Int seed) -> Game:
+  frm board : Board
+  frm moves = 0
+  while moves < 3:
+    act mark(Int cell) {cell >= 0, cell < 3, board.cells[cell] == 0}
+    board.cells[cell] = moves + 1
+    moves = moves + 1
+
+fun main() -> Int:
+  let game = play(5)
+  game.mark(0)
+  let log : GameUndoLog
+  record_undo(game, log)
+  game.mark(2)
+  if game.moves != 2 or game.board.cells[2] != 2:
+    return 1
+  undo(game, log)
+  if game.moves != 1 or game.board.cells[2] != 0 or game.board.cells[0] != 1:
+    return 2
+
+  # the log can be reused, and restores the resumption point too
+  record_undo(game, log)
+  game.mark(1)
+  game.mark(2)
+  if !game.is_done():
+    return 3
+  undo(game, log)
+  if game.is_done() or game.moves != 1 or game.board.cells[1] != 0:
+    return 4
+  game.mark(2)
+  if game.board.cells[2] != 2:
+    return 5
+
+  # fields no action can write are not part of the log
+  record_undo(game, log)
+  game.seed = 7
+  undo(game, log)
+  if game.seed != 7:
+    return 6
+  return 0
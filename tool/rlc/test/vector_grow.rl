@@ -0,0 +1,42 @@
+# RUN: rlc %s -o %t -i %stdlib --sanitize
+# RUN: %t%exeext
+
+import collections.vector
+
+fun make(Int value) -> Vector<Int>:
+  let to_return : Vector<Int>
+  let i = 0
+  while i < value:
+    to_return.append(value)
+    i = i + 1
+  return to_return
+
+fun main() -> Int:
+  # elements own memory, so a relocation that copies or
+  # destroys them the wrong number of times is caught by
+  # the sanitizer
+  let x : Vector<Vector<Int>>
+  let i = 0
+  while i < 100:
+    x.append(make(i % 7))
+    i = i + 1
+  if x.size() != 100 or x.get(99).size() != 1 or x.get(13).get(5) != 6:
+    return 1
+
+  x.erase(0)
+  x.drop_back(10)
+  let last = x.pop()
+  if x.size() != 88 or last.size() != 5 or x.get(0).size() != 1:
+    return 2
+
+  x.resize(200)
+  if x.get(150).size() != 0 or x.get(87).size() != 4:
+    return 3
+  x.get(199).append(3)
+
+  let y : Vector<Vector<Int>>
+  y = x
+  x.clear()
+  if !x.empty() or y.size() != 200 or y.get(199).get(0) != 3:
+    return 4
+  return 0
@@ -0,0 +1,69 @@
+# RUN: rlc %s -o %t -i %stdlib
+# RUN: %t%exeext
+
+import action
+
+act play() -> Game:
+  frm flag = false
+  frm cell : BInt<0, 2>
+  act set()
+  flag = true
+  cell.value = 1
+
+fun float32_at(Vector<Byte> bytes, Int index) -> Int:
+  let result = 0
+  let counter = 3
+  while counter >= 0:
+    result = (result << 8) | (int(bytes.get(index * 4 + counter)) & 255)
+    counter = counter - 1
+  return result
+
+fun float32_bits(Float value) -> Int:
+  let bytes : Vector<Byte>
+  bytes.resize(5)
+  # the destination needs not be aligned
+  __builtin_store_float32_do_not_use(bytes._data[1], value)
+  let result = 0
+  let counter = 4
+  while counter >= 1:
+    result = (result << 8) | (int(bytes.get(counter)) & 255)
+    counter = counter - 1
+  return result
+
+fun main() -> Int:
+  if float32_bits(1.0) != 1065353216 or float32_bits(0.0) != 0:
+    return 1
+  # 0.1 rounds up, -2.5 is exact
+  if float32_bits(0.1) != 1036831949 or float32_bits(-2.5) != 3223322624:
+    return 2
+  # too large values become infinities
+  if float32_bits(1000000000000000000000000000000000000000000.0) != 2139095040:
+    return 3
+  # values too small to be normal are kept as subnormals
+  let subnormal = 1.0
+  let halvings = 0
+  while halvings != 140:
+    subnormal = subnormal / 2.0
+    halvings = halvings + 1
+  if float32_bits(subnormal) != 512:
+    return 9
+
+  let states : Vector<Game>
+  states.append(play())
+  states.append(play())
+  states.get(1).set()
+  if observation_tensor_size(states.get(0)) != 3:
+    return 4
+
+  # 3 slots of tensor and one of padding per game
+  let output : Vector<Byte>
+  write_observations(states, 0, 4, output)
+  if output.size() != 32:
+    return 5
+  if float32_at(output, 0) != 0 or float32_at(output, 1) != 1065353216 or float32_at(output, 2) != 0:
+    return 6
+  if float32_at(output, 4) != 1065353216 or float32_at(output, 5) != 0 or float32_at(output, 6) != 1065353216:
+    return 7
+  if float32_at(output, 3) != 0 or float32_at(output, 7) != 0:
+    return 8
+  return 0